@@ -1,6 +1,7 @@
 #include "hl_monitoring/calibrated_image.h"
 
 #include <hl_communication/utils.h>
+#include <hl_monitoring/undistorter.h>
 
 #include <stdexcept>
 
@@ -15,12 +16,19 @@ CalibratedImage::CalibratedImage()
 CalibratedImage::CalibratedImage(const cv::Mat& img_, const Pose3D& pose, const IntrinsicParameters& camera_parameters)
   : img(img_)
 {
-  camera_meta.mutable_pose()->CopyFrom(pose);
-  camera_meta.mutable_camera_parameters()->CopyFrom(camera_parameters);
+  std::shared_ptr<CameraMetaInformation> meta = std::make_shared<CameraMetaInformation>();
+  meta->mutable_pose()->CopyFrom(pose);
+  meta->mutable_camera_parameters()->CopyFrom(camera_parameters);
+  camera_meta = std::move(meta);
 }
 
 CalibratedImage::CalibratedImage(const cv::Mat& img_, const CameraMetaInformation& camera_meta_)
-  : img(img_), camera_meta(camera_meta_)
+  : img(img_), camera_meta(std::make_shared<CameraMetaInformation>(camera_meta_))
+{
+}
+
+CalibratedImage::CalibratedImage(const cv::Mat& img_, std::shared_ptr<const CameraMetaInformation> camera_meta_)
+  : img(img_), camera_meta(std::move(camera_meta_))
 {
 }
 
@@ -30,18 +38,28 @@ const cv::Mat& CalibratedImage::getImg() const
 }
 
 const CameraMetaInformation& CalibratedImage::getCameraInformation() const
+{
+  if (!camera_meta)
+  {
+    static const CameraMetaInformation empty_meta;
+    return empty_meta;
+  }
+  return *camera_meta;
+}
+
+const std::shared_ptr<const CameraMetaInformation>& CalibratedImage::getSharedCameraInformation() const
 {
   return camera_meta;
 }
 
 bool CalibratedImage::hasCameraParameters() const
 {
-  return camera_meta.has_camera_parameters();
+  return camera_meta && camera_meta->has_camera_parameters();
 }
 
 bool CalibratedImage::hasPose() const
 {
-  return camera_meta.has_pose();
+  return camera_meta && camera_meta->has_pose();
 }
 
 void CalibratedImage::exportCameraParameters(cv::Mat* camera_matrix, cv::Mat* distortion_coefficients,
@@ -49,14 +67,14 @@ void CalibratedImage::exportCameraParameters(cv::Mat* camera_matrix, cv::Mat* di
 {
   if (hasCameraParameters())
   {
-    intrinsicToCV(camera_meta.camera_parameters(), camera_matrix, distortion_coefficients, size);
+    intrinsicToCV(camera_meta->camera_parameters(), camera_matrix, distortion_coefficients, size);
   }
 }
 void CalibratedImage::exportPose(cv::Mat* rvec, cv::Mat* tvec) const
 {
   if (hasPose())
   {
-    pose3DToCV(camera_meta.pose(), rvec, tvec);
+    pose3DToCV(camera_meta->pose(), rvec, tvec);
   }
 }
 
@@ -65,4 +83,19 @@ bool CalibratedImage::isFullySpecified() const
   return hasPose() && hasCameraParameters();
 }
 
+CalibratedImage CalibratedImage::getUndistorted(Undistorter* undistorter) const
+{
+  if (!hasCameraParameters() || img.empty())
+  {
+    return *this;
+  }
+  return CalibratedImage(undistorter->undistort(img, camera_meta->camera_parameters()),
+                         undistorter->getUndistortedMeta(camera_meta));
+}
+
+CalibratedImage CalibratedImage::getUndistorted() const
+{
+  return getUndistorted(&Undistorter::getDefault());
+}
+
 }  // namespace hl_monitoring
@@ -4,10 +4,17 @@
 
 #include <opencv2/core.hpp>
 
+#include <memory>
+
 namespace hl_monitoring
 {
+class Undistorter;
+
 /**
  * Represents an image along with its intrinsic and extrinsic parameters
+ *
+ * Camera meta information is immutable and shared between all the images using the same parameters, copying or moving
+ * a CalibratedImage does not copy the image content nor the meta information.
  */
 class CalibratedImage
 {
@@ -16,11 +23,20 @@ public:
   CalibratedImage(const cv::Mat& img, const hl_communication::Pose3D& pose,
                   const hl_communication::IntrinsicParameters& camera_parameters);
   CalibratedImage(const cv::Mat& img, const hl_communication::CameraMetaInformation& camera_meta);
+  /**
+   * camera_meta: shared meta information, if null, image is considered as not calibrated
+   */
+  CalibratedImage(const cv::Mat& img, std::shared_ptr<const hl_communication::CameraMetaInformation> camera_meta);
 
   const cv::Mat& getImg() const;
 
   const hl_communication::CameraMetaInformation& getCameraInformation() const;
 
+  /**
+   * Return the handle on the meta information of the image, might be null
+   */
+  const std::shared_ptr<const hl_communication::CameraMetaInformation>& getSharedCameraInformation() const;
+
   bool hasCameraParameters() const;
   bool hasPose() const;
 
@@ -32,10 +48,21 @@ public:
    */
   bool isFullySpecified() const;
 
+  /**
+   * Return a copy of the image without distortion, along with meta information describing the undistorted image.
+   * Images without camera parameters are returned as is.
+   */
+  CalibratedImage getUndistorted(Undistorter* undistorter) const;
+
+  /**
+   * Same as above with the default undistorter
+   */
+  CalibratedImage getUndistorted() const;
+
 private:
   cv::Mat img;
 
-  hl_communication::CameraMetaInformation camera_meta;
+  std::shared_ptr<const hl_communication::CameraMetaInformation> camera_meta;
 };
 
 }  // namespace hl_monitoring
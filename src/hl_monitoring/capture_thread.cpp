@@ -0,0 +1,109 @@
+#include "hl_monitoring/capture_thread.h"
+
+#include <hl_communication/utils.h>
+
+#include <chrono>
+
+namespace hl_monitoring
+{
+CaptureThread::CaptureThread(GrabFunction grab_, size_t buffer_size)
+  : grab(grab_), buffer(buffer_size), running(false), nb_dropped_frames(0), failed(false)
+{
+  if (buffer_size == 0)
+  {
+    throw std::logic_error(HL_DEBUG + " buffer_size should be strictly positive");
+  }
+}
+
+CaptureThread::~CaptureThread()
+{
+  stop();
+}
+
+void CaptureThread::start()
+{
+  if (thread.joinable())
+  {
+    throw std::logic_error(HL_DEBUG + " capture thread is already started");
+  }
+  running = true;
+  thread = std::thread(&CaptureThread::run, this);
+}
+
+void CaptureThread::stop()
+{
+  running = false;
+  if (thread.joinable())
+  {
+    thread.join();
+  }
+}
+
+bool CaptureThread::isRunning() const
+{
+  return running;
+}
+
+bool CaptureThread::pop(TimedFrame* frame)
+{
+  if (buffer.pop(frame))
+  {
+    return true;
+  }
+  checkError();
+  return false;
+}
+
+void CaptureThread::waitFrame(TimedFrame* frame)
+{
+  while (!pop(frame))
+  {
+    std::unique_lock<std::mutex> lock(wait_mutex);
+    // Timeout ensures that a stopped or failed capture thread never blocks the consumer forever
+    frame_available.wait_for(lock, std::chrono::milliseconds(10), [this]() { return buffer.size() > 0 || failed; });
+    if (!running && buffer.size() == 0 && !failed)
+    {
+      throw std::logic_error(HL_DEBUG + " waiting for a frame while capture thread is not running");
+    }
+  }
+}
+
+uint64_t CaptureThread::getNbDroppedFrames() const
+{
+  return nb_dropped_frames;
+}
+
+void CaptureThread::run()
+{
+  while (running)
+  {
+    TimedFrame frame;
+    try
+    {
+      grab(&frame);
+    }
+    catch (...)
+    {
+      error = std::current_exception();
+      failed = true;
+      running = false;
+      frame_available.notify_all();
+      return;
+    }
+    if (!buffer.push(std::move(frame)))
+    {
+      nb_dropped_frames++;
+    }
+    frame_available.notify_one();
+  }
+}
+
+void CaptureThread::checkError() const
+{
+  if (failed)
+  {
+    std::rethrow_exception(error);
+  }
+}
+
+}  // namespace hl_monitoring
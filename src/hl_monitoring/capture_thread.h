@@ -0,0 +1,112 @@
+#pragma once
+
+#include "hl_monitoring/ring_buffer.h"
+
+#include <opencv2/core.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace hl_monitoring
+{
+/**
+ * An image received from a live stream along with its acquisition time stamps
+ */
+struct TimedFrame
+{
+  cv::Mat img;
+
+  /**
+   * Acquisition time according to steady_clock [us]
+   */
+  uint64_t monotonic_ts = 0;
+
+  /**
+   * Acquisition time according to system_clock [us]
+   */
+  uint64_t utc_ts = 0;
+};
+
+/**
+ * Polls images from a live stream in a dedicated thread and stores them in a bounded lock-free ring buffer.
+ *
+ * The thread owning the CaptureThread is the only consumer of the frames, the capture thread is the only producer.
+ * If the consumer does not retrieve frames fast enough, the most recent frames are dropped and counted.
+ */
+class CaptureThread
+{
+public:
+  /**
+   * A function blocking until a new frame is available and filling its content. It should throw an exception if it
+   * fails to grab an image, this stops the capture thread and the exception is forwarded to the consumer.
+   */
+  typedef std::function<void(TimedFrame* frame)> GrabFunction;
+
+  /**
+   * buffer_size: number of frames which can be stored while waiting to be consumed
+   */
+  CaptureThread(GrabFunction grab, size_t buffer_size);
+  ~CaptureThread();
+
+  void start();
+
+  /**
+   * Request the end of the capture and wait for the thread to finish. Frames already captured are not cleared.
+   */
+  void stop();
+
+  bool isRunning() const;
+
+  /**
+   * Retrieve the oldest frame not consumed yet. Returns false if no frames are available.
+   * If the capture thread failed, the exception it raised is thrown.
+   */
+  bool pop(TimedFrame* frame);
+
+  /**
+   * Wait until a frame is available and retrieve it.
+   * If the capture thread failed, the exception it raised is thrown.
+   */
+  void waitFrame(TimedFrame* frame);
+
+  /**
+   * Number of frames which were grabbed while the buffer was full
+   */
+  uint64_t getNbDroppedFrames() const;
+
+private:
+  void run();
+
+  /**
+   * Throws the exception raised in the capture thread if there was one
+   */
+  void checkError() const;
+
+  GrabFunction grab;
+
+  SPSCRingBuffer<TimedFrame> buffer;
+
+  std::thread thread;
+
+  std::atomic<bool> running;
+
+  std::atomic<uint64_t> nb_dropped_frames;
+
+  /**
+   * Exception raised by the capture thread, only read once 'failed' has been set
+   */
+  std::exception_ptr error;
+  std::atomic<bool> failed;
+
+  /**
+   * Used to wake up a consumer waiting for a frame, the buffer itself is not protected by this mutex
+   */
+  std::mutex wait_mutex;
+  std::condition_variable frame_available;
+};
+
+}  // namespace hl_monitoring
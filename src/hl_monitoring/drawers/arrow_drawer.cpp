@@ -1,6 +1,7 @@
 #include <hl_monitoring/drawers/arrow_drawer.h>
 
 #include <hl_communication/utils.h>
+#include <hl_monitoring/profiler.h>
 
 #include <opencv2/imgproc.hpp>
 
@@ -21,6 +22,7 @@ ArrowDrawer::~ArrowDrawer()
 
 void ArrowDrawer::draw(FieldToImgConverter converter, const std::pair<cv::Point3f, cv::Point3f>& segment, cv::Mat* out)
 {
+  ScopedTimer timer("ArrowDrawer::draw");
   cv::Point2f img_src, img_end;
   bool valid_src = converter(segment.first, &img_src);
   bool valid_end = converter(segment.second, &img_end);
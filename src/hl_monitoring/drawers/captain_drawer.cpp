@@ -1,5 +1,7 @@
 #include <hl_monitoring/drawers/captain_drawer.h>
 
+#include <hl_monitoring/profiler.h>
+
 #include <opencv2/imgproc.hpp>
 
 using namespace hl_communication;
@@ -19,6 +21,7 @@ CaptainDrawer::~CaptainDrawer()
 
 void CaptainDrawer::draw(FieldToImgConverter converter, const hl_communication::Captain& captain, cv::Mat* out)
 {
+  ScopedTimer timer("CaptainDrawer::draw");
   if (captain.has_ball())
   {
     ball_drawer.draw(converter, captain.ball().position(), out);
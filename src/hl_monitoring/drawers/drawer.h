@@ -1,6 +1,7 @@
 #pragma once
 
 #include <hl_monitoring/top_view_drawer.h>
+#include <hl_monitoring/drawers/field_to_img_converter.h>
 #include <hl_communication/camera.pb.h>
 #include <hl_communication/utils.h>
 #include <hl_communication/wrapper.pb.h>
@@ -14,13 +15,6 @@ namespace hl_monitoring
 {
 class TopViewDrawer;
 
-/**
- * The contract of a field to image converter is to convert a field_pos to an img_pos.
- * If the img_pos is outside of the image or if the point is behind the camera, 'false' is returned,
- * on success, 'true' is returned.
- */
-typedef std::function<bool(const cv::Point3f& field_pos, cv::Point2f* img_pos)> FieldToImgConverter;
-
 template <class T>
 class Drawer
 {
@@ -44,9 +38,7 @@ public:
   virtual void drawNatural(const hl_communication::CameraMetaInformation& camera_information, const T& data,
                            cv::Mat* out)
   {
-    FieldToImgConverter converter = [camera_information](const cv::Point3f& field_pos, cv::Point2f* img_pos) {
-      return hl_communication::fieldToImg(field_pos, camera_information, img_pos);
-    };
+    FieldToImgConverter converter(camera_information);
     draw(converter, data, out);
   }
 
@@ -56,10 +48,11 @@ public:
    */
   virtual void drawTopView(const Field& f, const TopViewDrawer& top_view_drawer, const T& data, cv::Mat* out)
   {
-    FieldToImgConverter converter = [f, top_view_drawer](const cv::Point3f& field_pos, cv::Point2f* img_pos) {
+    // Converter is only used during the call to draw, capturing by reference avoids copying the field
+    FieldToImgConverter converter([&f, &top_view_drawer](const cv::Point3f& field_pos, cv::Point2f* img_pos) {
       *img_pos = top_view_drawer.getImgFromField(f, field_pos);
       return true;
-    };
+    });
     draw(converter, data, out);
   }
 
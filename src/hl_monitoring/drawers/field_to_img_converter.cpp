@@ -0,0 +1,155 @@
+#include <hl_monitoring/drawers/field_to_img_converter.h>
+
+#include <hl_communication/utils.h>
+
+#include <opencv2/calib3d.hpp>
+
+using namespace hl_communication;
+
+namespace hl_monitoring
+{
+struct FieldToImgConverter::CameraModel
+{
+  /**
+   * Rotation (row-major) and translation from field to camera referential
+   */
+  double r[9];
+  double t[3];
+
+  double fx, fy, cx, cy;
+
+  double k1, k2, p1, p2, k3;
+
+  double width, height;
+};
+
+bool FieldToImgConverter::projectPoint(const CameraModel& m, const cv::Point3f& field_pos, cv::Point2f* img_pos)
+{
+  // Computations are done without branches to allow vectorization of loops calling this function
+  double xc = m.r[0] * field_pos.x + m.r[1] * field_pos.y + m.r[2] * field_pos.z + m.t[0];
+  double yc = m.r[3] * field_pos.x + m.r[4] * field_pos.y + m.r[5] * field_pos.z + m.t[1];
+  double zc = m.r[6] * field_pos.x + m.r[7] * field_pos.y + m.r[8] * field_pos.z + m.t[2];
+  double inv_z = zc > 0 ? 1.0 / zc : 0.0;
+  double x = xc * inv_z;
+  double y = yc * inv_z;
+  double r2 = x * x + y * y;
+  double radial = 1 + r2 * (m.k1 + r2 * (m.k2 + r2 * m.k3));
+  double xd = x * radial + 2 * m.p1 * x * y + m.p2 * (r2 + 2 * x * x);
+  double yd = y * radial + m.p1 * (r2 + 2 * y * y) + 2 * m.p2 * x * y;
+  double u = m.fx * xd + m.cx;
+  double v = m.fy * yd + m.cy;
+  // Beyond the point where the radial distortion stops being monotonic, the projection folds back into the image
+  double radial_derivative = 1 + r2 * (3 * m.k1 + r2 * (5 * m.k2 + r2 * 7 * m.k3));
+  img_pos->x = u;
+  img_pos->y = v;
+  return (zc > 0) & (radial_derivative > 0) & (u >= 0) & (u < m.width) & (v >= 0) & (v < m.height);
+}
+
+FieldToImgConverter::FieldToImgConverter(PointConverter point_converter_) : point_converter(point_converter_)
+{
+}
+
+FieldToImgConverter::FieldToImgConverter(const CameraMetaInformation& camera_information)
+{
+  bool supported = camera_information.has_camera_parameters() && camera_information.has_pose();
+  cv::Mat camera_matrix, distortion_coefficients, rvec, tvec;
+  cv::Size size;
+  if (supported)
+  {
+    intrinsicToCV(camera_information.camera_parameters(), &camera_matrix, &distortion_coefficients, &size);
+    pose3DToCV(camera_information.pose(), &rvec, &tvec);
+    supported = distortion_coefficients.total() <= 5;
+  }
+  if (!supported)
+  {
+    point_converter = [camera_information](const cv::Point3f& field_pos, cv::Point2f* img_pos) {
+      return fieldToImg(field_pos, camera_information, img_pos);
+    };
+    return;
+  }
+  std::shared_ptr<CameraModel> model = std::make_shared<CameraModel>();
+  cv::Mat rotation;
+  cv::Rodrigues(rvec, rotation);
+  rotation.convertTo(rotation, CV_64F);
+  tvec.convertTo(tvec, CV_64F);
+  camera_matrix.convertTo(camera_matrix, CV_64F);
+  for (int idx = 0; idx < 9; idx++)
+  {
+    model->r[idx] = rotation.at<double>(idx / 3, idx % 3);
+  }
+  for (int idx = 0; idx < 3; idx++)
+  {
+    model->t[idx] = tvec.at<double>(idx);
+  }
+  model->fx = camera_matrix.at<double>(0, 0);
+  model->fy = camera_matrix.at<double>(1, 1);
+  model->cx = camera_matrix.at<double>(0, 2);
+  model->cy = camera_matrix.at<double>(1, 2);
+  double coeffs[5] = { 0, 0, 0, 0, 0 };
+  cv::Mat distortion_64;
+  distortion_coefficients.convertTo(distortion_64, CV_64F);
+  for (size_t idx = 0; idx < distortion_64.total(); idx++)
+  {
+    coeffs[idx] = distortion_64.at<double>(idx);
+  }
+  model->k1 = coeffs[0];
+  model->k2 = coeffs[1];
+  model->p1 = coeffs[2];
+  model->p2 = coeffs[3];
+  model->k3 = coeffs[4];
+  model->width = size.width;
+  model->height = size.height;
+  camera_model = model;
+}
+
+bool FieldToImgConverter::operator()(const cv::Point3f& field_pos, cv::Point2f* img_pos) const
+{
+  if (camera_model)
+  {
+    return projectPoint(*camera_model, field_pos, img_pos);
+  }
+  return point_converter(field_pos, img_pos);
+}
+
+void FieldToImgConverter::convert(const std::vector<cv::Point3f>& field_pos, std::vector<cv::Point2f>* img_pos,
+                                  std::vector<uint8_t>* valid) const
+{
+  size_t nb_points = field_pos.size();
+  img_pos->resize(nb_points);
+  valid->resize(nb_points);
+  const cv::Point3f* src = field_pos.data();
+  cv::Point2f* dst = img_pos->data();
+  uint8_t* dst_valid = valid->data();
+  if (camera_model)
+  {
+    const CameraModel& model = *camera_model;
+    for (size_t idx = 0; idx < nb_points; idx++)
+    {
+      dst_valid[idx] = projectPoint(model, src[idx], dst + idx);
+    }
+  }
+  else
+  {
+    for (size_t idx = 0; idx < nb_points; idx++)
+    {
+      dst_valid[idx] = point_converter(src[idx], dst + idx);
+    }
+  }
+}
+
+void FieldToImgConverter::convertValid(const std::vector<cv::Point3f>& field_pos,
+                                       std::vector<cv::Point>* img_pos) const
+{
+  std::vector<cv::Point2f> all_img_pos;
+  std::vector<uint8_t> valid;
+  convert(field_pos, &all_img_pos, &valid);
+  for (size_t idx = 0; idx < field_pos.size(); idx++)
+  {
+    if (valid[idx])
+    {
+      img_pos->push_back(all_img_pos[idx]);
+    }
+  }
+}
+
+}  // namespace hl_monitoring
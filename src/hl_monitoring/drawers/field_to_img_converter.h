@@ -0,0 +1,70 @@
+#pragma once
+
+#include <hl_communication/camera.pb.h>
+
+#include <opencv2/core.hpp>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace hl_monitoring
+{
+/**
+ * The contract of a field to image converter is to convert a field_pos to an img_pos.
+ * If the img_pos is outside of the image or if the point is behind the camera, 'false' is returned,
+ * on success, 'true' is returned.
+ *
+ * Converters built from camera meta information project points with the pinhole model and the distortion of the
+ * camera directly, without going through cv::Mat. Their batch conversion is a branchless loop which can be
+ * vectorized by the compiler, it should be preferred when many points are projected at once.
+ */
+class FieldToImgConverter
+{
+public:
+  typedef std::function<bool(const cv::Point3f& field_pos, cv::Point2f* img_pos)> PointConverter;
+
+  /**
+   * Build a converter based on a function converting a single point, batch conversions call the function for each
+   * point
+   */
+  FieldToImgConverter(PointConverter point_converter);
+
+  /**
+   * Build a converter projecting points in the image of the given camera.
+   * If the camera model is not supported (missing parameters, rational distortion model), conversions are delegated
+   * to hl_communication::fieldToImg.
+   */
+  FieldToImgConverter(const hl_communication::CameraMetaInformation& camera_information);
+
+  bool operator()(const cv::Point3f& field_pos, cv::Point2f* img_pos) const;
+
+  /**
+   * Convert all the points of field_pos, img_pos and valid are resized to the number of points.
+   * valid[i] is 1 if img_pos[i] is inside the image and in front of the camera, 0 otherwise.
+   */
+  void convert(const std::vector<cv::Point3f>& field_pos, std::vector<cv::Point2f>* img_pos,
+               std::vector<uint8_t>* valid) const;
+
+  /**
+   * Convert all the points of field_pos and append the valid ones to img_pos, order is preserved
+   */
+  void convertValid(const std::vector<cv::Point3f>& field_pos, std::vector<cv::Point>* img_pos) const;
+
+private:
+  /**
+   * Pinhole model with distortion coefficients k1, k2, p1, p2, k3
+   */
+  struct CameraModel;
+
+  static bool projectPoint(const CameraModel& model, const cv::Point3f& field_pos, cv::Point2f* img_pos);
+
+  PointConverter point_converter;
+
+  /**
+   * Shared between copies of the converter, null if point_converter is used
+   */
+  std::shared_ptr<const CameraModel> camera_model;
+};
+
+}  // namespace hl_monitoring
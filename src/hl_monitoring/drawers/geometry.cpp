@@ -2,21 +2,32 @@
 
 #include <opencv2/imgproc.hpp>
 
+#include <cmath>
+
 namespace hl_monitoring
 {
-// TODO: refactor code here -> duplication
-
-void drawGroundDisk(cv::Mat* out, FieldToImgConverter converter, const cv::Point2f& ground_center, double radius,
-                    const cv::Scalar& color, double alpha, double arc_step)
+/**
+ * Return the visible points of the projection of a circle on the ground, all points are projected at once
+ */
+static std::vector<cv::Point> getGroundCirclePoints(const FieldToImgConverter& converter,
+                                                    const cv::Point2f& ground_center, double radius, double arc_step)
 {
-  std::vector<cv::Point> img_points;
+  std::vector<cv::Point3f> obj_points;
+  obj_points.reserve(std::ceil(2 * M_PI / arc_step));
   for (double angle = 0; angle < 2 * M_PI; angle += arc_step)
   {
-    cv::Point3f obj_pos(ground_center.x + radius * cos(angle), ground_center.y + radius * sin(angle), 0);
-    cv::Point2f img_pos;
-    if (converter(obj_pos, &img_pos))
-      img_points.push_back(img_pos);
+    obj_points.push_back(
+        cv::Point3f(ground_center.x + radius * cos(angle), ground_center.y + radius * sin(angle), 0));
   }
+  std::vector<cv::Point> img_points;
+  converter.convertValid(obj_points, &img_points);
+  return img_points;
+}
+
+void drawGroundDisk(cv::Mat* out, FieldToImgConverter converter, const cv::Point2f& ground_center, double radius,
+                    const cv::Scalar& color, double alpha, double arc_step)
+{
+  std::vector<cv::Point> img_points = getGroundCirclePoints(converter, ground_center, radius, arc_step);
   if (img_points.size() > 0)
   {
     if (alpha >= 1.0)
@@ -25,9 +36,8 @@ void drawGroundDisk(cv::Mat* out, FieldToImgConverter converter, const cv::Point
     }
     else
     {
-      cv::Mat cpy = out->clone();
-      cv::fillConvexPoly(cpy, img_points, color, cv::LINE_AA);
-      cv::addWeighted(cpy, alpha, *out, 1 - alpha, 0, *out);
+      drawTranslucent(out, getBoundingRect(img_points), alpha,
+                      [&](cv::Mat* layer) { cv::fillConvexPoly(*layer, img_points, color, cv::LINE_AA); });
     }
   }
 }
@@ -35,18 +45,34 @@ void drawGroundDisk(cv::Mat* out, FieldToImgConverter converter, const cv::Point
 void drawGroundCircle(cv::Mat* out, FieldToImgConverter converter, const cv::Point2f& ground_center, double radius,
                       const cv::Scalar& color, double thickness, double arc_step)
 {
-  std::vector<cv::Point> img_points;
-  for (double angle = 0; angle < 2 * M_PI; angle += arc_step)
-  {
-    cv::Point3f obj_pos(ground_center.x + radius * cos(angle), ground_center.y + radius * sin(angle), 0);
-    cv::Point2f img_pos;
-    if (converter(obj_pos, &img_pos))
-      img_points.push_back(img_pos);
-  }
+  std::vector<cv::Point> img_points = getGroundCirclePoints(converter, ground_center, radius, arc_step);
   if (img_points.size() > 0)
   {
     cv::polylines(*out, img_points, true, color, thickness, cv::LINE_AA);
   }
 }
 
+void drawTranslucent(cv::Mat* out, const cv::Rect& area, double alpha,
+                     const std::function<void(cv::Mat* layer)>& draw_layer)
+{
+  cv::Rect roi = area & cv::Rect(0, 0, out->cols, out->rows);
+  if (roi.empty())
+  {
+    return;
+  }
+  // Only allocated when the size or the type of the output changes
+  static thread_local cv::Mat layer;
+  layer.create(out->size(), out->type());
+  (*out)(roi).copyTo(layer(roi));
+  draw_layer(&layer);
+  cv::Mat out_roi = (*out)(roi);
+  cv::addWeighted(layer(roi), alpha, out_roi, 1 - alpha, 0, out_roi);
+}
+
+cv::Rect getBoundingRect(const std::vector<cv::Point>& points, int margin)
+{
+  cv::Rect rect = cv::boundingRect(points);
+  return cv::Rect(rect.x - margin, rect.y - margin, rect.width + 2 * margin, rect.height + 2 * margin);
+}
+
 }  // namespace hl_monitoring
@@ -2,6 +2,8 @@
 
 #include <hl_monitoring/drawers/drawer.h>
 
+#include <functional>
+
 namespace hl_monitoring
 {
 /**
@@ -22,4 +24,18 @@ void drawGroundDisk(cv::Mat* out, FieldToImgConverter converter, const cv::Point
 void drawGroundCircle(cv::Mat* out, FieldToImgConverter converter, const cv::Point2f& ground_center, double radius,
                       const cv::Scalar& color, double thickness = 1.0, double arc_step = M_PI / 180);
 
+/**
+ * Blend shapes with the content of 'out' inside 'area' only.
+ * draw_layer receives a layer with the size of 'out' on which only 'area' is initialized with the content of 'out',
+ * shapes drawn outside of 'area' are ignored. The layer is reused between calls.
+ * alpha: transparency level (1.0 -> opaque)
+ */
+void drawTranslucent(cv::Mat* out, const cv::Rect& area, double alpha,
+                     const std::function<void(cv::Mat* layer)>& draw_layer);
+
+/**
+ * Return the bounding rectangle of the points, enlarged by margin on each side [px]
+ */
+cv::Rect getBoundingRect(const std::vector<cv::Point>& points, int margin = 2);
+
 }  // namespace hl_monitoring
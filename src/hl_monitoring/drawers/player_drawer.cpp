@@ -4,6 +4,7 @@
 
 #include <hl_communication/perception.pb.h>
 #include <hl_communication/utils.h>
+#include <hl_monitoring/profiler.h>
 
 #include <opencv2/imgproc.hpp>
 
@@ -24,6 +25,7 @@ PlayerDrawer::~PlayerDrawer()
 
 void PlayerDrawer::draw(FieldToImgConverter converter, const RobotMsg& robot, cv::Mat* out)
 {
+  ScopedTimer timer("PlayerDrawer::draw");
   if (robot.has_perception())
   {
     const Perception& perception = robot.perception();
@@ -1,6 +1,7 @@
 #include <hl_monitoring/drawers/pose_drawer.h>
 
 #include <hl_communication/utils.h>
+#include <hl_monitoring/profiler.h>
 #include <hl_monitoring/drawers/geometry.h>
 
 #include <iostream>
@@ -23,6 +24,7 @@ PoseDrawer::~PoseDrawer()
 
 void PoseDrawer::draw(FieldToImgConverter converter, const hl_communication::PoseDistribution& pose, cv::Mat* out)
 {
+  ScopedTimer timer("PoseDrawer::draw");
   if (!pose.has_position())
   {
     return;
@@ -40,11 +42,6 @@ void PoseDrawer::draw(FieldToImgConverter converter, const hl_communication::Pos
   bool has_covariance = exportUncertainty(pos, &covMat);
   if (has_covariance)
   {
-    // TODO: refactor
-    // overlay for opacity
-    cv::Mat overlay;
-    overlay = out->clone();
-
     cv::Mat eigenvalues, eigenvectors;
     cv::eigen(covMat, eigenvalues, eigenvectors);
 
@@ -69,7 +66,12 @@ void PoseDrawer::draw(FieldToImgConverter converter, const hl_communication::Pos
     getEllipsePoint(converter, field_pos, nbPoint, angle, axes, 0, 2 * M_PI, &ellipsePoints);
 
     cv::RotatedRect ellipse = fitEllipse(ellipsePoints);
-    cv::ellipse(overlay, ellipse, color, cv::FILLED, cv::LINE_AA);
+    // Both shapes are blended at once, only inside the area they cover
+    cv::Rect area = ellipse.boundingRect();
+    // Margin for anti-aliasing
+    area -= cv::Point(2, 2);
+    area += cv::Size(4, 4);
+    std::vector<cv::Point> dirPoints;
 
     if (pose.has_dir() && pose.dir().has_std_dev())
     {
@@ -82,12 +84,10 @@ void PoseDrawer::draw(FieldToImgConverter converter, const hl_communication::Pos
         float cone_dir_min = dir_rad - offset;
         float cone_dir_max = dir_rad + offset;
 
-        std::vector<cv::Point> dirPoints;
         getEllipsePoint(converter, field_pos, nbPoint, angle, axes, cone_dir_min, cone_dir_max, &dirPoints);
 
         dirPoints.push_back(img_pos);
-
-        cv::fillConvexPoly(overlay, dirPoints, color * 1.5, cv::LINE_AA);
+        area |= getBoundingRect(dirPoints);
       }
     }
 
@@ -97,7 +97,13 @@ void PoseDrawer::draw(FieldToImgConverter converter, const hl_communication::Pos
     double opacity =
         (max_opacity - min_opacity) * exp(-5 * eigenvalues.at<float>(0) * eigenvalues.at<float>(1)) + min_opacity;
 
-    cv::addWeighted(overlay, opacity, *out, 1 - opacity, 0, *out);
+    drawTranslucent(out, area, opacity, [&](cv::Mat* layer) {
+      cv::ellipse(*layer, ellipse, color, cv::FILLED, cv::LINE_AA);
+      if (dirPoints.size() > 0)
+      {
+        cv::fillConvexPoly(*layer, dirPoints, color * 1.5, cv::LINE_AA);
+      }
+    });
   }
   else
   {
@@ -134,21 +140,16 @@ void PoseDrawer::getEllipsePoint(FieldToImgConverter converter, cv::Point3f fiel
                                  double angle_ellipse, std::pair<float, float> axes, double start_angle,
                                  double end_angle, std::vector<cv::Point>* ellipsePoints)
 {
+  std::vector<cv::Point3f> ellipse_field_points;
+  ellipse_field_points.reserve(nbPoints);
   for (float i = start_angle - angle_ellipse; i < end_angle - angle_ellipse; i += (M_PI * 2) / nbPoints)
   {
     float x, y;
     x = axes.first * cos(i) * cos(angle_ellipse) - axes.second * sin(i) * sin(angle_ellipse) + field_pos.x;
     y = axes.first * cos(i) * sin(angle_ellipse) + axes.second * sin(i) * cos(angle_ellipse) + field_pos.y;
-
-    cv::Point2f img_pos_ellipse;
-    cv::Point3f ellipse_pos(x, y, 0);
-    bool valid_pos_ellipse = converter(ellipse_pos, &img_pos_ellipse);
-
-    if (valid_pos_ellipse)
-    {
-      ellipsePoints->push_back(img_pos_ellipse);
-    }
+    ellipse_field_points.push_back(cv::Point3f(x, y, 0));
   }
+  converter.convertValid(ellipse_field_points, ellipsePoints);
 }
 
 void PoseDrawer::setColor(const cv::Scalar& new_color)
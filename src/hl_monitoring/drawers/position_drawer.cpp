@@ -1,6 +1,7 @@
 #include <hl_monitoring/drawers/position_drawer.h>
 
 #include <hl_communication/utils.h>
+#include <hl_monitoring/profiler.h>
 #include <hl_monitoring/drawers/geometry.h>
 
 #include <opencv2/imgproc.hpp>
@@ -19,6 +20,7 @@ PositionDrawer::~PositionDrawer()
 
 void PositionDrawer::draw(FieldToImgConverter converter, const PositionDistribution& pos, cv::Mat* out)
 {
+  ScopedTimer timer("PositionDrawer::draw");
   drawGroundDisk(out, converter, cv::Point2f(pos.x(), pos.y()), circle_radius, color);
 }
 
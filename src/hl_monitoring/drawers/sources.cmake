@@ -1,6 +1,7 @@
 set(SOURCES
   arrow_drawer.cpp
   captain_drawer.cpp
+  field_to_img_converter.cpp
   geometry.cpp
   player_drawer.cpp
   position_drawer.cpp
@@ -1,6 +1,7 @@
 #include <hl_monitoring/drawers/team_drawer.h>
 
 #include <hl_communication/utils.h>
+#include <hl_monitoring/profiler.h>
 
 #include <opencv2/imgproc.hpp>
 
@@ -19,6 +20,7 @@ TeamDrawer::~TeamDrawer()
 void TeamDrawer::draw(FieldToImgConverter converter, const hl_communication::MessageManager::Status& status,
                       cv::Mat* out)
 {
+  ScopedTimer timer("TeamDrawer::draw");
   updateColorsById(status.gc_message);
   for (const auto& entry : status.getRobotsByTeam())
   {
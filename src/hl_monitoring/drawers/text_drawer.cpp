@@ -1,6 +1,7 @@
 #include <hl_monitoring/drawers/text_drawer.h>
 
 #include <hl_communication/utils.h>
+#include <hl_monitoring/profiler.h>
 
 #include <opencv2/imgproc.hpp>
 
@@ -18,6 +19,7 @@ TextDrawer::~TextDrawer()
 
 void TextDrawer::draw(FieldToImgConverter converter, const std::pair<cv::Point3f, std::string>& data, cv::Mat* out)
 {
+  ScopedTimer timer("TextDrawer::draw");
   cv::Point3f field_pos = data.first;
   const std::string& msg = data.second;
   cv::Point2f img_pos;
@@ -1,11 +1,13 @@
 #include "hl_monitoring/field.h"
 
 #include <hl_communication/utils.h>
+#include <hl_monitoring/profiler.h>
 #include <opencv2/calib3d.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/imgproc.hpp>
 #include <RhIO.hpp>
 
+#include <atomic>
 #include <fstream>
 #include <iostream>
 
@@ -15,6 +17,138 @@ using namespace hl_communication;
 
 namespace hl_monitoring
 {
+/**
+ * Coordinates used to build the points of interest, computed from the dimensions of the field
+ */
+enum POICoordinate
+{
+  Zero,
+  ArenaHalfLength,
+  FieldHalfLength,
+  GoalAreaX,
+  PenaltyMarkX,
+  PenaltyAreaX,
+  CenterRadius,
+  ArenaHalfWidth,
+  FieldHalfWidth,
+  GoalAreaHalfWidth,
+  GoalHalfWidth,
+  PenaltyAreaHalfWidth,
+  NbPOICoordinates
+};
+
+/**
+ * Position of a point of interest: (x_sign * x, y_sign * y, 0)
+ */
+struct POIDefinition
+{
+  const char* name;
+  Field::POIType type;
+  POICoordinate x;
+  int x_sign;
+  POICoordinate y;
+  int y_sign;
+  /**
+   * Points related to the penalty area only exist if penalty_area_length is positive
+   */
+  bool penalty_area;
+};
+
+typedef Field::POIId POIId;
+
+/**
+ * Standard layout, ordered as POIId
+ */
+static constexpr POIDefinition poi_definitions[] = {
+  { "center", Field::Center, Zero, 1, Zero, 1, false },
+  { "center_x+", Field::X, Zero, 1, CenterRadius, 1, false },
+  { "center_x-", Field::X, Zero, 1, CenterRadius, -1, false },
+  { "arena_corner++", Field::ArenaCorner, ArenaHalfLength, 1, ArenaHalfWidth, 1, false },
+  { "arena_corner+-", Field::ArenaCorner, ArenaHalfLength, 1, ArenaHalfWidth, -1, false },
+  { "arena_corner-+", Field::ArenaCorner, ArenaHalfLength, -1, ArenaHalfWidth, 1, false },
+  { "arena_corner--", Field::ArenaCorner, ArenaHalfLength, -1, ArenaHalfWidth, -1, false },
+  { "field_corner++", Field::LineCorner, FieldHalfLength, 1, FieldHalfWidth, 1, false },
+  { "field_corner+-", Field::LineCorner, FieldHalfLength, 1, FieldHalfWidth, -1, false },
+  { "field_corner-+", Field::LineCorner, FieldHalfLength, -1, FieldHalfWidth, 1, false },
+  { "field_corner--", Field::LineCorner, FieldHalfLength, -1, FieldHalfWidth, -1, false },
+  { "goal_area_corner++", Field::LineCorner, GoalAreaX, 1, GoalAreaHalfWidth, 1, false },
+  { "goal_area_corner+-", Field::LineCorner, GoalAreaX, 1, GoalAreaHalfWidth, -1, false },
+  { "goal_area_corner-+", Field::LineCorner, GoalAreaX, -1, GoalAreaHalfWidth, 1, false },
+  { "goal_area_corner--", Field::LineCorner, GoalAreaX, -1, GoalAreaHalfWidth, -1, false },
+  { "goal_area_t++", Field::T, FieldHalfLength, 1, GoalAreaHalfWidth, 1, false },
+  { "goal_area_t+-", Field::T, FieldHalfLength, 1, GoalAreaHalfWidth, -1, false },
+  { "goal_area_t-+", Field::T, FieldHalfLength, -1, GoalAreaHalfWidth, 1, false },
+  { "goal_area_t--", Field::T, FieldHalfLength, -1, GoalAreaHalfWidth, -1, false },
+  { "penalty_mark+", Field::PenaltyMark, PenaltyMarkX, 1, Zero, 1, false },
+  { "penalty_mark-", Field::PenaltyMark, PenaltyMarkX, -1, Zero, 1, false },
+  { "middle_line_t+", Field::T, Zero, 1, FieldHalfWidth, 1, false },
+  { "middle_line_t-", Field::T, Zero, 1, FieldHalfWidth, -1, false },
+  { "post_base++", Field::PostBase, FieldHalfLength, 1, GoalHalfWidth, 1, false },
+  { "post_base+-", Field::PostBase, FieldHalfLength, 1, GoalHalfWidth, -1, false },
+  { "post_base-+", Field::PostBase, FieldHalfLength, -1, GoalHalfWidth, 1, false },
+  { "post_base--", Field::PostBase, FieldHalfLength, -1, GoalHalfWidth, -1, false },
+  { "penalty_area_corner++", Field::LineCorner, PenaltyAreaX, 1, PenaltyAreaHalfWidth, 1, true },
+  { "penalty_area_corner+-", Field::LineCorner, PenaltyAreaX, 1, PenaltyAreaHalfWidth, -1, true },
+  { "penalty_area_corner-+", Field::LineCorner, PenaltyAreaX, -1, PenaltyAreaHalfWidth, 1, true },
+  { "penalty_area_corner--", Field::LineCorner, PenaltyAreaX, -1, PenaltyAreaHalfWidth, -1, true },
+  { "penalty_area_t++", Field::T, FieldHalfLength, 1, PenaltyAreaHalfWidth, 1, true },
+  { "penalty_area_t+-", Field::T, FieldHalfLength, 1, PenaltyAreaHalfWidth, -1, true },
+  { "penalty_area_t-+", Field::T, FieldHalfLength, -1, PenaltyAreaHalfWidth, 1, true },
+  { "penalty_area_t--", Field::T, FieldHalfLength, -1, PenaltyAreaHalfWidth, -1, true },
+};
+
+static_assert(sizeof(poi_definitions) / sizeof(POIDefinition) == (size_t)POIId::Count,
+              "poi_definitions should contain exactly one entry per POIId");
+
+struct SegmentDefinition
+{
+  POIId start;
+  POIId end;
+};
+
+/**
+ * White lines of the standard layout, lines using points which are not part of the layout are skipped
+ */
+static constexpr SegmentDefinition white_line_definitions[] = {
+  { POIId::FieldCornerPP, POIId::FieldCornerPM },
+  { POIId::FieldCornerPM, POIId::FieldCornerMM },
+  { POIId::FieldCornerMM, POIId::FieldCornerMP },
+  { POIId::FieldCornerMP, POIId::FieldCornerPP },
+  { POIId::MiddleLineTP, POIId::MiddleLineTM },
+  { POIId::GoalAreaTPP, POIId::GoalAreaCornerPP },
+  { POIId::GoalAreaCornerPP, POIId::GoalAreaCornerPM },
+  { POIId::GoalAreaCornerPM, POIId::GoalAreaTPM },
+  { POIId::GoalAreaTMP, POIId::GoalAreaCornerMP },
+  { POIId::GoalAreaCornerMP, POIId::GoalAreaCornerMM },
+  { POIId::GoalAreaCornerMM, POIId::GoalAreaTMM },
+  { POIId::PenaltyAreaTPP, POIId::PenaltyAreaCornerPP },
+  { POIId::PenaltyAreaCornerPP, POIId::PenaltyAreaCornerPM },
+  { POIId::PenaltyAreaCornerPM, POIId::PenaltyAreaTPM },
+  { POIId::PenaltyAreaTMP, POIId::PenaltyAreaCornerMP },
+  { POIId::PenaltyAreaCornerMP, POIId::PenaltyAreaCornerMM },
+  { POIId::PenaltyAreaCornerMM, POIId::PenaltyAreaTMM },
+};
+
+static constexpr SegmentDefinition arena_border_definitions[] = {
+  { POIId::ArenaCornerPP, POIId::FieldCornerPM },
+  { POIId::ArenaCornerPM, POIId::FieldCornerMM },
+  { POIId::FieldCornerMM, POIId::FieldCornerMP },
+  { POIId::FieldCornerMP, POIId::FieldCornerPP },
+};
+
+/**
+ * Goals: first the x- and then the x+
+ */
+static constexpr SegmentDefinition goal_definitions[] = {
+  { POIId::PostBaseMP, POIId::PostBaseMM },
+  { POIId::PostBasePP, POIId::PostBasePM },
+};
+
+static constexpr POIId goal_post_ids[] = { POIId::PostBasePP, POIId::PostBasePM, POIId::PostBaseMP,
+                                           POIId::PostBaseMM };
+
+static constexpr POIId penalty_mark_ids[] = { POIId::PenaltyMarkP, POIId::PenaltyMarkM };
+
 std::vector<Field::POIType> Field::poi_type_values = { Field::POIType::ArenaCorner, Field::POIType::LineCorner,
                                                        Field::POIType::T,           Field::POIType::X,
                                                        Field::POIType::Center,      Field::POIType::PenaltyMark,
@@ -68,7 +202,40 @@ const std::vector<Field::POIType>& Field::getPOITypeValues()
   return poi_type_values;
 }
 
-Field::Field()
+const char* Field::getPOIName(POIId id)
+{
+  return poi_definitions[(size_t)id].name;
+}
+
+Field::POIType Field::getPOIType(POIId id)
+{
+  return poi_definitions[(size_t)id].type;
+}
+
+Field::POIId Field::getPOIId(const std::string& name)
+{
+  static std::map<std::string, POIId> ids_by_name;
+  if (ids_by_name.size() == 0)
+  {
+    for (size_t idx = 0; idx < (size_t)POIId::Count; idx++)
+    {
+      ids_by_name[poi_definitions[idx].name] = (POIId)idx;
+    }
+  }
+  auto it = ids_by_name.find(name);
+  if (it == ids_by_name.end())
+  {
+    throw std::out_of_range(HL_DEBUG + " unknown point of interest '" + name + "'");
+  }
+  return it->second;
+}
+
+/**
+ * Source of the versions of the fields, shared by all fields so that versions are never reused
+ */
+static std::atomic<uint64_t> next_version(1);
+
+Field::Field() : geometry_built(false), version(0)
 {
 //  ball_radius = 0.075;
   ball_radius = 0.1;
@@ -87,7 +254,6 @@ Field::Field()
   field_width = 6.00;
   penalty_area_length = 2.00;
   penalty_area_width = 5.00;
-  updateAll();
 
   bind = new RhIO::Bind("field");
 
@@ -105,6 +271,7 @@ Field::Field()
   bind->bindNew("border_strip_width_y", border_strip_width_y)->comment("Border strip width y")->defaultValue(border_strip_width_y);
 
   bind->pull();
+  updateGeometry();
 }
 
 void Field::updateFieldDimensions() {
@@ -122,6 +289,7 @@ void Field::updateFieldDimensions() {
   bind->node().setFloat("border_strip_width_y", border_strip_width_y);
 
   bind->pull();
+  updateGeometry();
 }
 
 Json::Value Field::toJson() const
@@ -165,8 +333,6 @@ void Field::fromJson(const Json::Value& v)
   readVal(v, "penalty_area_width", &penalty_area_width);
 
   updateFieldDimensions();
-  updateAll();
-
 }
 
 void Field::loadFile(const std::string& path)
@@ -190,7 +356,21 @@ bool Field::isInArena(const cv::Point2f& pos_in_field, double margin) const
 
 const cv::Point3f& Field::getPoint(const std::string& name) const
 {
-  return points_of_interest.at(name);
+  return getPoint(getPOIId(name));
+}
+
+const cv::Point3f& Field::getPoint(POIId id) const
+{
+  if (!hasPoint(id))
+  {
+    throw std::out_of_range(HL_DEBUG + " point '" + getPOIName(id) + "' is not part of the field");
+  }
+  return poi_positions[(size_t)id];
+}
+
+bool Field::hasPoint(POIId id) const
+{
+  return poi_available[(size_t)id];
 }
 
 const std::map<std::string, cv::Point3f>& Field::getPointsOfInterest() const
@@ -228,166 +408,119 @@ const Field::POICollection& Field::getPointsOfInterestByType() const
   return poi_by_type;
 }
 
-void Field::updateAll()
+bool Field::pullDimensions()
 {
-  updatePointsOfInterest();
-  updateWhiteLines();
-  updateArenaBorders();
-  updateGoals();
-  updatePenaltyMarks();
-  updatePointsOfInterestByType();
+  uint64_t previous_version = version;
+  bind->pull();
+  updateGeometry();
+  return version != previous_version;
 }
 
-void Field::updatePointsOfInterest()
+uint64_t Field::getVersion() const
 {
-  points_of_interest.clear();
-  points_of_interest["center"] = cv::Point3f(0, 0, 0);
-  points_of_interest["center_x+"] = cv::Point3f(0, center_radius, 0);
-  points_of_interest["center_x-"] = cv::Point3f(0, -center_radius, 0);
-  double ac_x = field_length / 2 + border_strip_width_x;
-  double ac_y = field_width / 2 + border_strip_width_y;
-  points_of_interest["arena_corner++"] = cv::Point3f(ac_x, ac_y, 0);
-  points_of_interest["arena_corner+-"] = cv::Point3f(ac_x, -ac_y, 0);
-  points_of_interest["arena_corner-+"] = cv::Point3f(-ac_x, ac_y, 0);
-  points_of_interest["arena_corner--"] = cv::Point3f(-ac_x, -ac_y, 0);
-  double fc_x = field_length / 2;
-  double fc_y = field_width / 2;
-  points_of_interest["field_corner++"] = cv::Point3f(fc_x, fc_y, 0);
-  points_of_interest["field_corner+-"] = cv::Point3f(fc_x, -fc_y, 0);
-  points_of_interest["field_corner-+"] = cv::Point3f(-fc_x, fc_y, 0);
-  points_of_interest["field_corner--"] = cv::Point3f(-fc_x, -fc_y, 0);
-  double gac_x = field_length / 2 - goal_area_length;
-  double gac_y = goal_area_width / 2;
-  points_of_interest["goal_area_corner++"] = cv::Point3f(gac_x, gac_y, 0);
-  points_of_interest["goal_area_corner+-"] = cv::Point3f(gac_x, -gac_y, 0);
-  points_of_interest["goal_area_corner-+"] = cv::Point3f(-gac_x, gac_y, 0);
-  points_of_interest["goal_area_corner--"] = cv::Point3f(-gac_x, -gac_y, 0);
-  double gat_x = field_length / 2;
-  double gat_y = goal_area_width / 2;
-  points_of_interest["goal_area_t++"] = cv::Point3f(gat_x, gat_y, 0);
-  points_of_interest["goal_area_t+-"] = cv::Point3f(gat_x, -gat_y, 0);
-  points_of_interest["goal_area_t-+"] = cv::Point3f(-gat_x, gat_y, 0);
-  points_of_interest["goal_area_t--"] = cv::Point3f(-gat_x, -gat_y, 0);
-  double pm_x = field_length / 2 - penalty_mark_dist;
-  points_of_interest["penalty_mark+"] = cv::Point3f(pm_x, 0, 0);
-  points_of_interest["penalty_mark-"] = cv::Point3f(-pm_x, 0, 0);
-  double mlt_y = field_width / 2;
-  points_of_interest["middle_line_t+"] = cv::Point3f(0, mlt_y, 0);
-  points_of_interest["middle_line_t-"] = cv::Point3f(0, -mlt_y, 0);
-  double goal_x = field_length / 2;
-  double goal_y = goal_width / 2;
-  points_of_interest["post_base++"] = cv::Point3f(goal_x, goal_y, 0);
-  points_of_interest["post_base+-"] = cv::Point3f(goal_x, -goal_y, 0);
-  points_of_interest["post_base-+"] = cv::Point3f(-goal_x, goal_y, 0);
-  points_of_interest["post_base--"] = cv::Point3f(-goal_x, -goal_y, 0);
-
-  if (penalty_area_length >= 0.0)
-  {
-    double pa_x = field_length / 2 - penalty_area_length;
-    double pa_y = penalty_area_width / 2;
-    points_of_interest["penalty_area_corner++"] = cv::Point3f(pa_x, pa_y, 0);
-    points_of_interest["penalty_area_corner+-"] = cv::Point3f(pa_x, -pa_y, 0);
-    points_of_interest["penalty_area_corner-+"] = cv::Point3f(-pa_x, pa_y, 0);
-    points_of_interest["penalty_area_corner--"] = cv::Point3f(-pa_x, -pa_y, 0);
-
-    double pat_x = field_length / 2;
-    double pat_y = penalty_area_width / 2;
-    points_of_interest["penalty_area_t++"] = cv::Point3f(pat_x, pat_y, 0);
-    points_of_interest["penalty_area_t+-"] = cv::Point3f(pat_x, -pat_y, 0);
-    points_of_interest["penalty_area_t-+"] = cv::Point3f(-pat_x, pat_y, 0);
-    points_of_interest["penalty_area_t--"] = cv::Point3f(-pat_x, -pat_y, 0);
-  }
+  return version;
 }
 
-void Field::updateWhiteLines()
+Field::Dimensions Field::getDimensions() const
 {
-  white_lines.clear();
-  white_lines.push_back({ getPoint("field_corner++"), getPoint("field_corner+-") });
-  white_lines.push_back({ getPoint("field_corner+-"), getPoint("field_corner--") });
-  white_lines.push_back({ getPoint("field_corner--"), getPoint("field_corner-+") });
-  white_lines.push_back({ getPoint("field_corner-+"), getPoint("field_corner++") });
-  white_lines.push_back({ getPoint("middle_line_t+"), getPoint("middle_line_t-") });
-  white_lines.push_back({ getPoint("goal_area_t++"), getPoint("goal_area_corner++") });
-  white_lines.push_back({ getPoint("goal_area_corner++"), getPoint("goal_area_corner+-") });
-  white_lines.push_back({ getPoint("goal_area_corner+-"), getPoint("goal_area_t+-") });
-  white_lines.push_back({ getPoint("goal_area_t-+"), getPoint("goal_area_corner-+") });
-  white_lines.push_back({ getPoint("goal_area_corner-+"), getPoint("goal_area_corner--") });
-  white_lines.push_back({ getPoint("goal_area_corner--"), getPoint("goal_area_t--") });
-
-  if (penalty_area_length >= 0.0)
-  {
-    white_lines.push_back({ getPoint("penalty_area_t++"), getPoint("penalty_area_corner++") });
-    white_lines.push_back({ getPoint("penalty_area_corner++"), getPoint("penalty_area_corner+-") });
-    white_lines.push_back({ getPoint("penalty_area_corner+-"), getPoint("penalty_area_t+-") });
-    white_lines.push_back({ getPoint("penalty_area_t-+"), getPoint("penalty_area_corner-+") });
-    white_lines.push_back({ getPoint("penalty_area_corner-+"), getPoint("penalty_area_corner--") });
-    white_lines.push_back({ getPoint("penalty_area_corner--"), getPoint("penalty_area_t--") });
-  }
+  return { ball_radius,         line_width,          center_radius,     border_strip_width_x, border_strip_width_y,
+           penalty_mark_dist,   penalty_mark_length, goal_width,        goal_depth,           goal_area_length,
+           goal_area_width,     field_length,        field_width,       penalty_area_length,  penalty_area_width };
 }
 
-void Field::updateArenaBorders()
+void Field::updateGeometry()
 {
-  arena_borders = { { getPoint("arena_corner++"), getPoint("field_corner+-") },
-                    { getPoint("arena_corner+-"), getPoint("field_corner--") },
-                    { getPoint("field_corner--"), getPoint("field_corner-+") },
-                    { getPoint("field_corner-+"), getPoint("field_corner++") } };
+  Dimensions dimensions = getDimensions();
+  if (geometry_built && dimensions == geometry_dimensions)
+  {
+    return;
+  }
+  geometry_dimensions = dimensions;
+  updatePointsOfInterest();
+  updateFeatures();
+  updatePointsOfInterestByType();
+  geometry_built = true;
+  version = next_version++;
 }
 
-void Field::updateGoals()
+void Field::updatePointsOfInterest()
 {
-  goals = { { getPoint("post_base-+"), getPoint("post_base--") },
-            { getPoint("post_base++"), getPoint("post_base+-") } };
-  goal_posts = { getPoint("post_base++"), getPoint("post_base+-"), getPoint("post_base-+"), getPoint("post_base--") };
+  double coordinates[NbPOICoordinates];
+  coordinates[Zero] = 0;
+  coordinates[ArenaHalfLength] = field_length / 2 + border_strip_width_x;
+  coordinates[FieldHalfLength] = field_length / 2;
+  coordinates[GoalAreaX] = field_length / 2 - goal_area_length;
+  coordinates[PenaltyMarkX] = field_length / 2 - penalty_mark_dist;
+  coordinates[PenaltyAreaX] = field_length / 2 - penalty_area_length;
+  coordinates[CenterRadius] = center_radius;
+  coordinates[ArenaHalfWidth] = field_width / 2 + border_strip_width_y;
+  coordinates[FieldHalfWidth] = field_width / 2;
+  coordinates[GoalAreaHalfWidth] = goal_area_width / 2;
+  coordinates[GoalHalfWidth] = goal_width / 2;
+  coordinates[PenaltyAreaHalfWidth] = penalty_area_width / 2;
+  bool has_penalty_area = penalty_area_length >= 0.0;
+  points_of_interest.clear();
+  for (size_t idx = 0; idx < (size_t)POIId::Count; idx++)
+  {
+    const POIDefinition& def = poi_definitions[idx];
+    poi_positions[idx] = cv::Point3f(def.x_sign * coordinates[def.x], def.y_sign * coordinates[def.y], 0);
+    poi_available[idx] = has_penalty_area || !def.penalty_area;
+    if (poi_available[idx])
+    {
+      points_of_interest[def.name] = poi_positions[idx];
+    }
+  }
 }
 
-void Field::updatePenaltyMarks()
+void Field::updateFeatures()
 {
-  penalty_marks = { getPoint("penalty_mark+"), getPoint("penalty_mark-") };
+  white_lines.clear();
+  for (const SegmentDefinition& def : white_line_definitions)
+  {
+    if (poi_available[(size_t)def.start] && poi_available[(size_t)def.end])
+    {
+      white_lines.push_back({ poi_positions[(size_t)def.start], poi_positions[(size_t)def.end] });
+    }
+  }
+  arena_borders.clear();
+  for (const SegmentDefinition& def : arena_border_definitions)
+  {
+    arena_borders.push_back({ poi_positions[(size_t)def.start], poi_positions[(size_t)def.end] });
+  }
+  goals.clear();
+  for (const SegmentDefinition& def : goal_definitions)
+  {
+    goals.push_back({ poi_positions[(size_t)def.start], poi_positions[(size_t)def.end] });
+  }
+  goal_posts.clear();
+  for (POIId id : goal_post_ids)
+  {
+    goal_posts.push_back(poi_positions[(size_t)id]);
+  }
+  penalty_marks.clear();
+  for (POIId id : penalty_mark_ids)
+  {
+    penalty_marks.push_back(poi_positions[(size_t)id]);
+  }
 }
 
 void Field::updatePointsOfInterestByType()
 {
   poi_by_type.clear();
-  for (const auto& entry : points_of_interest)
+  for (size_t idx = 0; idx < (size_t)POIId::Count; idx++)
   {
-    POIType type = POIType::Unknown;
-    if (entry.first.find("arena_corner") != std::string::npos)
-    {
-      type = POIType::ArenaCorner;
-    }
-    else if (entry.first.find("corner") != std::string::npos)
-    {
-      type = POIType::LineCorner;
-    }
-    else if (entry.first.find("_t") != std::string::npos)
-    {
-      type = POIType::T;
-    }
-    else if (entry.first.find("_x") != std::string::npos)
+    if (poi_available[idx])
     {
-      type = POIType::X;
+      poi_by_type[poi_definitions[idx].type].push_back(poi_positions[idx]);
     }
-    else if (entry.first.find("penalty_mark") != std::string::npos)
-    {
-      type = POIType::PenaltyMark;
-    }
-    else if (entry.first.find("post_base") != std::string::npos)
-    {
-      type = POIType::PostBase;
-    }
-    else if (entry.first.find("center") != std::string::npos)
-    {
-      type = POIType::Center;
-    }
-    poi_by_type[type].push_back(entry.second);
   }
 }
 
 void Field::tagPointsOfInterest(const cv::Mat& camera_matrix, const cv::Mat& distortion_coeffs, const cv::Mat& rvec,
-                                const cv::Mat& tvec, cv::Mat* tag_img)
+                                const cv::Mat& tvec, cv::Mat* tag_img) const
 {
   cv::Rect2f img_rect(cv::Point2f(), cv::Point2f(tag_img->cols, tag_img->rows));
-  for (const auto& entry : poi_by_type)
+  for (const auto& entry : getPointsOfInterestByType())
   {
     const std::vector<cv::Point3f>& field_positions = entry.second;
     std::vector<cv::Point2f> img_points;
@@ -430,37 +563,58 @@ void Field::tagLines(const cv::Mat& camera_matrix, const cv::Mat& distortion_coe
                      const cv::Mat& tvec, cv::Mat* tag_img, const cv::Scalar& line_color, double line_thickness,
                      int nb_segments) const
 {
-  for (const auto& segment : getWhiteLines())
+  ScopedTimer timer("Field::tagLines");
+  std::vector<ImgSegment> img_segments;
+  projectLines(camera_matrix, distortion_coeffs, rvec, tvec, tag_img->size(), nb_segments, &img_segments);
+  for (const ImgSegment& segment : img_segments)
+  {
+    cv::line(*tag_img, segment.first, segment.second, line_color, line_thickness, cv::LINE_AA);
+  }
+}
+
+void Field::projectLines(const cv::Mat& camera_matrix, const cv::Mat& distortion_coeffs, const cv::Mat& rvec,
+                         const cv::Mat& tvec, const cv::Size& img_size, int nb_segments,
+                         std::vector<ImgSegment>* img_segments) const
+{
+  img_segments->clear();
+  const std::vector<Segment>& lines = getWhiteLines();
+  if (nb_segments <= 0 || lines.size() == 0)
+  {
+    return;
+  }
+  // Each line is sampled at nb_segments + 1 points, extremities are shared by consecutive parts
+  int points_per_line = nb_segments + 1;
+  std::vector<cv::Point3f> object_points;
+  object_points.reserve(lines.size() * points_per_line);
+  for (const auto& segment : lines)
   {
     cv::Point3f object_diff = segment.second - segment.first;
+    for (int i = 0; i <= nb_segments; i++)
+    {
+      object_points.push_back(segment.first + i * object_diff / nb_segments);
+    }
+  }
+  std::vector<bool> valid_points(object_points.size());
+  for (size_t idx = 0; idx < object_points.size(); idx++)
+  {
+    const cv::Point3f& obj_point = object_points[idx];
+    valid_points[idx] = hl_communication::fieldToCamera(obj_point, rvec, tvec).z > 0 &&
+                        isPointValidForCorrection(obj_point, rvec, tvec, camera_matrix, distortion_coeffs);
+  }
+  std::vector<cv::Point2f> img_points;
+  cv::projectPoints(object_points, rvec, tvec, camera_matrix, distortion_coeffs, img_points);
+  // When point is outside of image, screw up the drawing
+  cv::Rect2f img_rect(cv::Point(), img_size);
+  for (size_t line_idx = 0; line_idx < lines.size(); line_idx++)
+  {
     for (int i = 0; i < nb_segments; i++)
     {
-      std::vector<cv::Point3f> object_points = { segment.first + i * object_diff / nb_segments,
-                                                 segment.first + (i + 1) * object_diff / nb_segments };
-      bool has_point_behind = false;
-      for (const cv::Point3f& obj_point : object_points)
-      {
-        cv::Point3f point_in_camera = hl_communication::fieldToCamera(obj_point, rvec, tvec);
-        if (point_in_camera.z <= 0)
-        {
-          has_point_behind = true;
-        }
-      }
-      if (has_point_behind)
-      {
-        continue;
-      }
-      std::vector<cv::Point2f> img_points;
-      if (not isPointValidForCorrection(object_points[0], rvec, tvec, camera_matrix, distortion_coeffs))
-        continue;
-      if (not isPointValidForCorrection(object_points[1], rvec, tvec, camera_matrix, distortion_coeffs))
-        continue;
-      cv::projectPoints(object_points, rvec, tvec, camera_matrix, distortion_coeffs, img_points);
-      // When point is outside of image, screw up the drawing
-      cv::Rect2f img_rect(cv::Point(), tag_img->size());
-      if (img_rect.contains(img_points[0]) && img_rect.contains(img_points[1]))
+      size_t start = line_idx * points_per_line + i;
+      size_t end = start + 1;
+      if (valid_points[start] && valid_points[end] && img_rect.contains(img_points[start]) &&
+          img_rect.contains(img_points[end]))
       {
-        cv::line(*tag_img, img_points[0], img_points[1], line_color, line_thickness, cv::LINE_AA);
+        img_segments->push_back({ img_points[start], img_points[end] });
       }
     }
   }
@@ -477,7 +631,7 @@ double Field::getArenaWidth() const
 }
 
 void Field::overview(const cv::Mat* tag_img, const cv::Scalar& line_color, double line_thickness,
-                     const cv::Point3f circle, int rows = 0, int cols = 0)
+                     const cv::Point3f circle, int rows = 0, int cols = 0) const
 {
   // size of the field in meters
   float max_size_x = field_length + 2 * border_strip_width_x;
@@ -507,7 +661,7 @@ void Field::overview(const cv::Mat* tag_img, const cv::Scalar& line_color, doubl
   }
 
   // generation of the point of interest markers
-  for (const auto& entry : poi_by_type)
+  for (const auto& entry : getPointsOfInterestByType())
   {
     const std::vector<cv::Point3f>& field_positions = entry.second;
     cv::MarkerTypes marker;
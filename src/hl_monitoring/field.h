@@ -6,6 +6,10 @@
 
 #include <RhIO.hpp>
 
+#include <array>
+#include <cstdint>
+#include <map>
+
 namespace hl_monitoring
 {
 /**
@@ -43,12 +47,21 @@ namespace hl_monitoring
  *         |--------------------------------|
  *
  * - All field informations are in meters
+ *
+ * The geometry (points of interest, lines, goals...) is rebuilt by the methods modifying the dimensions, const methods
+ * only read it. Therefore, const methods can be called from several threads at once, as long as the field is not
+ * modified at the same time.
  */
 class Field
 {
 public:
   typedef std::pair<cv::Point3f, cv::Point3f> Segment;
 
+  /**
+   * A segment in image referential [px]
+   */
+  typedef std::pair<cv::Point2f, cv::Point2f> ImgSegment;
+
   enum POIType
   {
     ArenaCorner,
@@ -61,7 +74,50 @@ public:
     Unknown
   };
 
-    /**
+  /**
+   * Identifiers of the points of interest of the standard layout, signs refer to the x and y coordinates
+   */
+  enum class POIId
+  {
+    Center,
+    CenterXPlus,
+    CenterXMinus,
+    ArenaCornerPP,
+    ArenaCornerPM,
+    ArenaCornerMP,
+    ArenaCornerMM,
+    FieldCornerPP,
+    FieldCornerPM,
+    FieldCornerMP,
+    FieldCornerMM,
+    GoalAreaCornerPP,
+    GoalAreaCornerPM,
+    GoalAreaCornerMP,
+    GoalAreaCornerMM,
+    GoalAreaTPP,
+    GoalAreaTPM,
+    GoalAreaTMP,
+    GoalAreaTMM,
+    PenaltyMarkP,
+    PenaltyMarkM,
+    MiddleLineTP,
+    MiddleLineTM,
+    PostBasePP,
+    PostBasePM,
+    PostBaseMP,
+    PostBaseMM,
+    PenaltyAreaCornerPP,
+    PenaltyAreaCornerPM,
+    PenaltyAreaCornerMP,
+    PenaltyAreaCornerMM,
+    PenaltyAreaTPP,
+    PenaltyAreaTPM,
+    PenaltyAreaTMP,
+    PenaltyAreaTMM,
+    Count
+  };
+
+  /**
    * Map of points of interests ordered by Type
    */
   typedef std::map<POIType, std::vector<cv::Point3f>> POICollection;
@@ -69,6 +125,18 @@ public:
 
     static std::string poiType2String(Field::POIType type);
     static const std::vector<Field::POIType>& getPOITypeValues();
+
+  /**
+   * Name of the point of interest, e.g. 'field_corner+-'
+   */
+  static const char* getPOIName(POIId id);
+  static POIType getPOIType(POIId id);
+
+  /**
+   * Throws an out_of_range exception on invalid name
+   */
+  static POIId getPOIId(const std::string& name);
+
   Field();
 
   Json::Value toJson() const;
@@ -81,10 +149,19 @@ public:
   bool isInArena(const cv::Point2f& pos_in_field, double margin=0.) const;
 
   /**
-   * Throws an out_of_range exception on invalid name
+   * Throws an out_of_range exception on invalid name or if the point is not part of the current layout
    */
   const cv::Point3f& getPoint(const std::string& name) const;
+  const cv::Point3f& getPoint(POIId id) const;
+
+  /**
+   * Return false if the point is not part of the current layout (e.g. no penalty area)
+   */
+  bool hasPoint(POIId id) const;
 
+  /**
+   * Points of interest indexed by name
+   */
   const std::map<std::string, cv::Point3f>& getPointsOfInterest() const;
 
     const std::vector<Segment>& getArenaBorders() const;
@@ -100,7 +177,7 @@ public:
   const POICollection& getPointsOfInterestByType() const;
 
   void tagPointsOfInterest(const cv::Mat& camera_matrix, const cv::Mat& distortion_coeffs, const cv::Mat& rvec,
-                           const cv::Mat& tvec, cv::Mat* tag_img);
+                           const cv::Mat& tvec, cv::Mat* tag_img) const;
 
   void tagLines(const hl_communication::CameraMetaInformation& camera_information, cv::Mat* tag_img,
                 const cv::Scalar& line_color, double line_thickness, int nb_segments = 1) const;
@@ -108,6 +185,14 @@ public:
     void tagLines(const cv::Mat& camera_matrix, const cv::Mat& distortion_coeffs, const cv::Mat& rvec,
                 const cv::Mat& tvec, cv::Mat* tag_img, const cv::Scalar& line_color, double line_thickness,
                 int nb_segments = 1) const;
+
+  /**
+   * Split each white line in nb_segments parts and project them in an image of the given size. Only the parts which
+   * are fully visible are written in img_segments. All the points are projected at once.
+   */
+  void projectLines(const cv::Mat& camera_matrix, const cv::Mat& distortion_coeffs, const cv::Mat& rvec,
+                    const cv::Mat& tvec, const cv::Size& img_size, int nb_segments,
+                    std::vector<ImgSegment>* img_segments) const;
   double getArenaLength() const;
 
     double getArenaWidth() const;
@@ -115,7 +200,7 @@ public:
    * Generates a flat drawing of the terrain
    */
   void overview(const cv::Mat* tag_imag, const cv::Scalar& line_color, double line_thickness, const cv::Point3f circle,
-                int rows, int cols);
+                int rows, int cols) const;
 
   /**
    * Radius of the ball [m]
@@ -194,46 +279,73 @@ public:
 
   RhIO::Bind* bind;
 
+  /**
+   * Read the values tuned over RhIO into the dimensions, returns true if the field was modified. Meant to be called
+   * once per iteration of the main loop, derived geometry is rebuilt at most once per modification.
+   */
+  bool pullDimensions();
+
+  /**
+   * Rebuild the geometry if the dimensions changed since last build, has to be called after modifying the dimensions
+   * directly
+   */
+  void updateGeometry();
+
+  /**
+   * Identifier of the current state of the dimensions, it changes each time the dimensions of a field are modified
+   * and is never shared by two different states, even among different fields. Dependents can therefore invalidate
+   * their caches by comparing a single integer.
+   */
+  uint64_t getVersion() const;
+
 private:
-    /**
-   * Synchronize all the features with the current field dimensions
+  /**
+   * Values of all the dimensions of the field
    */
-  void updateAll();
-    /**
+  typedef std::array<double, 15> Dimensions;
+
+  Dimensions getDimensions() const;
+
+  /**
    * Synchronize the points of interests with current size of the field
    */
   void updatePointsOfInterest();
 
   /**
-   * Synchronize the white lines based on the points of interest
+   * Synchronize the segments, goals and penalty marks based on the points of interest
    */
-  void updateWhiteLines();
+  void updateFeatures();
 
   /**
-   * Synchronize the arena borders based on the points of interest
+   * Synchronize poi_by_type based on the points of interest
    */
-  void updateArenaBorders();
+  void updatePointsOfInterestByType();
+
+  void updateFieldDimensions();
 
   /**
-   * Synchronize the goals and goal posts based on the points of interest
+   * Dimensions used for the last build of the geometry, valid only if geometry_built is true
    */
-  void updateGoals();
+  Dimensions geometry_dimensions;
+  bool geometry_built;
 
   /**
-   * Synchronize the penalty marks based on the points of interest
+   * Version associated to geometry_dimensions, see getVersion
    */
-  void updatePenaltyMarks();
+  uint64_t version;
 
   /**
-   * Synchronize poi_by_type based on points_of_interest
+   * Positions of the points of interest indexed by POIId
    */
-  void updatePointsOfInterestByType();
+  std::array<cv::Point3f, (size_t)POIId::Count> poi_positions;
 
-  void updateFieldDimensions();
+  /**
+   * Is the point part of the current layout
+   */
+  std::array<bool, (size_t)POIId::Count> poi_available;
 
   /**
-   * Stores points of interest visually identifiable of the field along with a given name.
-   * e.g.: corners penalty marks etc...
+   * Points of interest indexed by name
    */
   std::map<std::string, cv::Point3f> points_of_interest;
 
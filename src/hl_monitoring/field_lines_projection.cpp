@@ -0,0 +1,65 @@
+#include "hl_monitoring/field_lines_projection.h"
+
+#include <hl_communication/utils.h>
+#include <hl_monitoring/profiler.h>
+#include <opencv2/imgproc.hpp>
+
+#include <sstream>
+
+using namespace hl_communication;
+
+namespace hl_monitoring
+{
+FieldLinesProjection::FieldLinesProjection() : field_version(0), nb_segments(0)
+{
+}
+
+const std::vector<Field::ImgSegment>&
+FieldLinesProjection::getSegments(const Field& field, const std::shared_ptr<const CameraMetaInformation>& new_meta,
+                                  int new_nb_segments)
+{
+  if (!new_meta || !new_meta->has_camera_parameters() || !new_meta->has_pose())
+  {
+    throw std::runtime_error(HL_DEBUG + " camera_information is not fully specified");
+  }
+  if (new_meta == camera_meta && new_nb_segments == nb_segments && field.getVersion() == field_version)
+  {
+    return img_segments;
+  }
+  cv::Mat camera_matrix, distortion_coefficients, rvec, tvec;
+  intrinsicToCV(new_meta->camera_parameters(), &camera_matrix, &distortion_coefficients, &img_size);
+  pose3DToCV(new_meta->pose(), &rvec, &tvec);
+  field.projectLines(camera_matrix, distortion_coefficients, rvec, tvec, img_size, new_nb_segments, &img_segments);
+  camera_meta = new_meta;
+  field_version = field.getVersion();
+  nb_segments = new_nb_segments;
+  return img_segments;
+}
+
+void FieldLinesProjection::tagLines(const Field& field, const CalibratedImage& img, cv::Mat* tag_img,
+                                    const cv::Scalar& line_color, double line_thickness, int new_nb_segments)
+{
+  ScopedTimer timer("FieldLinesProjection::tagLines");
+  const std::vector<Field::ImgSegment>& segments =
+      getSegments(field, img.getSharedCameraInformation(), new_nb_segments);
+  if (img_size.width != tag_img->cols || img_size.height != tag_img->rows)
+  {
+    std::ostringstream oss;
+    oss << HL_DEBUG << " size mismatch " << img_size << " != " << tag_img->size;
+    throw std::runtime_error(oss.str());
+  }
+  for (const Field::ImgSegment& segment : segments)
+  {
+    cv::line(*tag_img, segment.first, segment.second, line_color, line_thickness, cv::LINE_AA);
+  }
+}
+
+void FieldLinesProjection::clear()
+{
+  camera_meta.reset();
+  field_version = 0;
+  nb_segments = 0;
+  img_segments.clear();
+}
+
+}  // namespace hl_monitoring
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "hl_monitoring/calibrated_image.h"
+#include "hl_monitoring/field.h"
+
+#include <memory>
+
+namespace hl_monitoring
+{
+/**
+ * Keeps the projection of the white lines of a field for a camera.
+ *
+ * Projection is only computed again when the camera meta information, the version of the field or the number of
+ * segments change. Since camera meta information is shared between images until parameters change, drawing the lines
+ * on a static camera only costs the drawing itself.
+ */
+class FieldLinesProjection
+{
+public:
+  FieldLinesProjection();
+
+  /**
+   * Return the visible parts of the white lines of the field for the given camera, see Field::projectLines
+   * throws a runtime_error if camera_meta is not fully specified
+   */
+  const std::vector<Field::ImgSegment>&
+  getSegments(const Field& field, const std::shared_ptr<const hl_communication::CameraMetaInformation>& camera_meta,
+              int nb_segments);
+
+  /**
+   * Draw the lines of the field on tag_img according to the camera parameters of img
+   */
+  void tagLines(const Field& field, const CalibratedImage& img, cv::Mat* tag_img, const cv::Scalar& line_color,
+                double line_thickness, int nb_segments = 1);
+
+  /**
+   * Discard the current projection
+   */
+  void clear();
+
+private:
+  /**
+   * Parameters used for the current projection
+   */
+  std::shared_ptr<const hl_communication::CameraMetaInformation> camera_meta;
+  uint64_t field_version;
+  int nb_segments;
+
+  /**
+   * Size of the image according to the camera parameters
+   */
+  cv::Size img_size;
+
+  std::vector<Field::ImgSegment> img_segments;
+};
+
+}  // namespace hl_monitoring
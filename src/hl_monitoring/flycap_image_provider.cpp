@@ -1,18 +1,33 @@
 #include "hl_monitoring/flycap_image_provider.h"
+#include "hl_monitoring/image_provider_factory.h"
+#include "hl_monitoring/meta_information_log.h"
 
 #include <hl_communication/utils.h>
 
 #include <opencv2/imgproc.hpp>
 
 #include <chrono>
-#include <fstream>
 #include <iostream>
+#include <sstream>
 
 using namespace std::chrono;
 using namespace hl_communication;
 
 namespace hl_monitoring
 {
+static std::unique_ptr<ImageProvider> buildFlyCapImageProvider(const Json::Value& v,
+                                                               const ImageProviderFactory::BuildContext& context)
+{
+  checkMember(v, "parameters");
+  return std::unique_ptr<ImageProvider>(new FlyCapImageProvider(v["parameters"], context.output_prefix));
+}
+
+/**
+ * Time stamps are measured on reception of the buffers, not by the camera
+ */
+static ImageProviderFactory::Registrar registrar("FlyCapImageProvider", buildFlyCapImageProvider,
+                                                 ImageProviderFactory::Capabilities(true, false, false));
+
 PtGreyException::PtGreyException(const std::string& msg) : std::runtime_error(msg)
 {
 }
@@ -40,12 +55,17 @@ FlyCapImageProvider::FlyCapImageProvider(const Json::Value& v, const std::string
     }
     has_guid = true;
   }
+  if (v.isMember("writer"))
+  {
+    output.fromJson(v["writer"]);
+  }
   openInputStream();
   getNextImg();
 }
 FlyCapImageProvider::~FlyCapImageProvider()
 {
   saveVideoMetaInformation();
+  output.close();
 }
 
 void FlyCapImageProvider::connect()
@@ -144,11 +164,26 @@ void FlyCapImageProvider::openOutputStream(const std::string& output_path)
   }
   bool use_color = true;
   std::cout << "Opening video_stream of size: " << img_size << std::endl;
-  output.open(output_path, cv::VideoWriter::fourcc('X', 'V', 'I', 'D'), frame_rate, img_size, use_color);
-  if (!output.isOpened())
+  output.open(output_path, output.getFourcc(), frame_rate, img_size, use_color);
+}
+
+VideoWriterStage& FlyCapImageProvider::getVideoWriter()
+{
+  return output;
+}
+
+std::string FlyCapImageProvider::getOutputVideoPath() const
+{
+  if (output_prefix == "")
   {
-    throw std::runtime_error(HL_DEBUG + "Failed to open video at '" + output_path + "'");
+    return "";
   }
+  return output.getVideoPath(output_prefix);
+}
+
+uint64_t FlyCapImageProvider::getNbDroppedFrames() const
+{
+  return output.getStatistics().nb_dropped;
 }
 
 void FlyCapImageProvider::restartStream()
@@ -162,13 +197,12 @@ CalibratedImage FlyCapImageProvider::getCalibratedImage(uint64_t time_stamp)
   {
     throw std::runtime_error(HL_DEBUG + " no frames found in the stream");
   }
-  if (time_stamp < indices_by_time_stamp.rbegin()->first)
+  if (time_stamp < getEnd())
   {
     throw std::runtime_error(HL_DEBUG + " asking for frames in the past is not supported");
   }
 
-  int index = indices_by_time_stamp.size() - 1;
-  return CalibratedImage(img, getCameraMetaInformation(index));
+  return CalibratedImage(img, getSharedCameraMetaInformation(index));
 }
 
 void FlyCapImageProvider::update()
@@ -209,19 +243,23 @@ cv::Mat FlyCapImageProvider::getNextImg()
     throw std::runtime_error(HL_DEBUG + "Blank frame at frame: " + std::to_string(index) + "/" +
                              std::to_string(nb_frames));
   }
-  cv::cvtColor(tmp_img, img, cv::COLOR_RGB2BGR);
+  // A new buffer is required for each image since previous ones might still be waiting to be encoded
+  cv::Mat new_img;
+  cv::cvtColor(tmp_img, new_img, cv::COLOR_RGB2BGR);
+  img = new_img;
   // register image
+  index = nb_frames;
   pushTimeStamp(index, monotonic_ts);
   FrameEntry* entry = meta_information.add_frames();
   entry->set_utc_ts(utc_ts);
   entry->set_monotonic_ts(monotonic_ts);
-  index++;
   nb_frames++;
   // Open output stream after capturing first image
   if (output_prefix != "" && !output.isOpened())
   {
     img_size = img.size();
-    openOutputStream(output_prefix + ".avi");
+    openOutputStream(getOutputVideoPath());
+    output.openMetaInformation(output_prefix + ".bin", extractHeader(&meta_information));
   }
   // Write image to output video if opened
   if (output.isOpened())
@@ -232,7 +270,7 @@ cv::Mat FlyCapImageProvider::getNextImg()
       oss << "Size mismatch: (video size: " << img_size << ", img size: " << img.size() << ")";
       throw std::runtime_error(HL_DEBUG + oss.str());
     }
-    output.write(img);
+    output.push(img, *entry);
   }
   return img;
 }
@@ -247,17 +285,18 @@ void FlyCapImageProvider::saveVideoMetaInformation()
   // Do not save if no output_prefix has been provided
   if (output_prefix == "")
     return;
+  output.writeHeader(extractHeader(&meta_information));
+}
 
-  std::string path = output_prefix + ".bin";
-  std::ofstream out(path, std::ios::binary);
-  if (!out.good())
-  {
-    throw std::runtime_error(HL_DEBUG + "Failed to open file '" + path + "'");
-  }
-  if (!meta_information.SerializeToOstream(&out))
-  {
-    throw std::runtime_error(HL_DEBUG + "Failed to write to file '" + path + "'");
-  }
+void FlyCapImageProvider::onHeaderChange()
+{
+  saveVideoMetaInformation();
+}
+
+void FlyCapImageProvider::onFrameChange(const FrameEntry& entry)
+{
+  // Entry has already been pushed to the writer, the update is applied when reading the meta information
+  output.writeFrameUpdate(entry);
 }
 
 void FlyCapImageProvider::updatePacketProperties()
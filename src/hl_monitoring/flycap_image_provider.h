@@ -1,6 +1,7 @@
 #pragma once
 
 #include "hl_monitoring/image_provider.h"
+#include "hl_monitoring/video_writer_stage.h"
 
 #include <json/json.h>
 #include <flycapture/FlyCapture2.h>
@@ -27,8 +28,7 @@ class FlyCapImageProvider : public ImageProvider
 {
 public:
   /**
-   * If output_prefix is not empty, write video during execution and saves
-   * MetaInformation when object is closed
+   * If output_prefix is not empty, write video and MetaInformation during execution
    */
   FlyCapImageProvider(const Json::Value& v, const std::string& output_prefix = "");
   virtual ~FlyCapImageProvider();
@@ -52,8 +52,24 @@ public:
 
   bool isStreamFinished() override;
 
+  /**
+   * Write the information shared by all the frames to the meta information file, frames are written as soon as they
+   * are encoded
+   */
   void saveVideoMetaInformation();
 
+  /**
+   * Access to the stage encoding the output video, allows to configure its queue
+   */
+  VideoWriterStage& getVideoWriter();
+
+  std::string getOutputVideoPath() const override;
+
+  /**
+   * Number of images dropped by the video writer
+   */
+  uint64_t getNbDroppedFrames() const override;
+
   void updateProperty(const FlyCapture2::Property& wished_property);
   void applyWishedProperties();
 
@@ -88,6 +104,10 @@ public:
    */
   void setPixelFormat(FlyCapture2::PixelFormat pixel_format);
 
+protected:
+  void onHeaderChange() override;
+  void onFrameChange(const hl_communication::FrameEntry& entry) override;
+
 private:
   /**
    * PtGrey camera
@@ -100,9 +120,9 @@ private:
   bool is_capturing;
 
   /**
-   * The video read from the file
+   * Encodes the images received in a video, from its own thread
    */
-  cv::VideoWriter output;
+  VideoWriterStage output;
 
   /**
    * Last img read
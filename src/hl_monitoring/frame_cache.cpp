@@ -0,0 +1,102 @@
+#include "hl_monitoring/frame_cache.h"
+
+namespace hl_monitoring
+{
+FrameCache::FrameCache(size_t max_size) : size(0), max_size(max_size)
+{
+}
+
+void FrameCache::setMaxSize(size_t new_max_size)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  max_size = new_max_size;
+  evict();
+}
+
+size_t FrameCache::getMaxSize() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return max_size;
+}
+
+size_t FrameCache::getSize() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return size;
+}
+
+size_t FrameCache::getNbFrames() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return entries.size();
+}
+
+bool FrameCache::get(int index, cv::Mat* img)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = entries.find(index);
+  if (it == entries.end())
+  {
+    return false;
+  }
+  lru_indices.splice(lru_indices.begin(), lru_indices, it->second.lru_it);
+  *img = it->second.img;
+  return true;
+}
+
+bool FrameCache::contains(int index) const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return entries.count(index) > 0;
+}
+
+void FrameCache::insert(int index, const cv::Mat& img)
+{
+  size_t img_size = getImgSize(img);
+  std::lock_guard<std::mutex> lock(mutex);
+  if (img_size > max_size)
+  {
+    return;
+  }
+  auto it = entries.find(index);
+  if (it != entries.end())
+  {
+    size -= getImgSize(it->second.img);
+    it->second.img = img;
+    lru_indices.splice(lru_indices.begin(), lru_indices, it->second.lru_it);
+  }
+  else
+  {
+    lru_indices.push_front(index);
+    entries[index] = { img, lru_indices.begin() };
+  }
+  size += img_size;
+  evict();
+}
+
+void FrameCache::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  entries.clear();
+  lru_indices.clear();
+  size = 0;
+}
+
+size_t FrameCache::getImgSize(const cv::Mat& img)
+{
+  return img.total() * img.elemSize();
+}
+
+void FrameCache::evict()
+{
+  while (size > max_size && !lru_indices.empty())
+  {
+    int index = lru_indices.back();
+    lru_indices.pop_back();
+    auto it = entries.find(index);
+    size -= getImgSize(it->second.img);
+    entries.erase(it);
+  }
+}
+
+}  // namespace hl_monitoring
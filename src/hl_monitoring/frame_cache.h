@@ -0,0 +1,88 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace hl_monitoring
+{
+/**
+ * A thread-safe least-recently-used cache of decoded images indexed by frame number.
+ *
+ * The cache is bounded by the memory used by the images it holds, when inserting a new image exceeds the budget, the
+ * least recently used images are evicted.
+ */
+class FrameCache
+{
+public:
+  /**
+   * max_size: memory budget [bytes], 0 disables the cache
+   */
+  FrameCache(size_t max_size = 0);
+
+  /**
+   * Set the memory budget [bytes], evicting images if required
+   */
+  void setMaxSize(size_t new_max_size);
+  size_t getMaxSize() const;
+
+  /**
+   * Memory currently used by the images in the cache [bytes]
+   */
+  size_t getSize() const;
+
+  size_t getNbFrames() const;
+
+  /**
+   * If the frame is in the cache, copy its header in 'img', mark it as recently used and return true. Otherwise,
+   * return false.
+   */
+  bool get(int index, cv::Mat* img);
+
+  /**
+   * Return true if the frame is in the cache, does not change its rank
+   */
+  bool contains(int index) const;
+
+  /**
+   * Insert the image in the cache, replacing previous image with the same index if there was one. Images larger than
+   * the budget are ignored. The content of 'img' should not be modified after this call.
+   */
+  void insert(int index, const cv::Mat& img);
+
+  void clear();
+
+private:
+  struct Entry
+  {
+    cv::Mat img;
+    /**
+     * Position of the entry in lru_indices
+     */
+    std::list<int>::iterator lru_it;
+  };
+
+  static size_t getImgSize(const cv::Mat& img);
+
+  /**
+   * Remove least recently used entries until the size fits the budget, mutex has to be locked
+   */
+  void evict();
+
+  mutable std::mutex mutex;
+
+  std::unordered_map<int, Entry> entries;
+
+  /**
+   * Indices of the frames, from most recently used to least recently used
+   */
+  std::list<int> lru_indices;
+
+  size_t size;
+
+  size_t max_size;
+};
+
+}  // namespace hl_monitoring
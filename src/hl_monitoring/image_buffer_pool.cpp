@@ -0,0 +1,62 @@
+#include "hl_monitoring/image_buffer_pool.h"
+
+namespace hl_monitoring
+{
+/**
+ * Return true if the image is only referenced by the pool
+ */
+static bool isUnused(const cv::Mat& buffer)
+{
+  return buffer.u != nullptr && buffer.u->refcount == 1;
+}
+
+ImageBufferPool::ImageBufferPool(size_t max_buffers_) : max_buffers(max_buffers_), nb_allocations(0)
+{
+}
+
+cv::Mat ImageBufferPool::acquire(const cv::Size& size, int type)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  for (auto it = buffers.begin(); it != buffers.end();)
+  {
+    if (!isUnused(*it))
+    {
+      it++;
+    }
+    else if (it->size() == size && it->type() == type)
+    {
+      return *it;
+    }
+    else
+    {
+      it = buffers.erase(it);
+    }
+  }
+  nb_allocations++;
+  cv::Mat buffer(size, type);
+  if (buffers.size() < max_buffers)
+  {
+    buffers.push_back(buffer);
+  }
+  return buffer;
+}
+
+size_t ImageBufferPool::getNbBuffers() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return buffers.size();
+}
+
+uint64_t ImageBufferPool::getNbAllocations() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return nb_allocations;
+}
+
+void ImageBufferPool::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  buffers.clear();
+}
+
+}  // namespace hl_monitoring
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace hl_monitoring
+{
+/**
+ * A set of image buffers reused once they are not referenced anymore, allows decoders to avoid an allocation per
+ * frame.
+ *
+ * A buffer is available again as soon as all the cv::Mat returned by acquire and their copies are released. If all
+ * the buffers are in use, acquire allocates a new image which is not kept by the pool. The pool can be shared by
+ * several providers, all methods are thread-safe.
+ */
+class ImageBufferPool
+{
+public:
+  /**
+   * max_buffers: maximal number of buffers kept by the pool
+   */
+  ImageBufferPool(size_t max_buffers = 16);
+
+  /**
+   * Return an image of the given size and type whose content is undefined. Buffers of another size or type are
+   * released if they are not used anymore.
+   */
+  cv::Mat acquire(const cv::Size& size, int type);
+
+  /**
+   * Number of buffers currently kept by the pool
+   */
+  size_t getNbBuffers() const;
+
+  /**
+   * Number of calls to acquire which required an allocation
+   */
+  uint64_t getNbAllocations() const;
+
+  void clear();
+
+private:
+  mutable std::mutex mutex;
+
+  std::vector<cv::Mat> buffers;
+
+  size_t max_buffers;
+
+  uint64_t nb_allocations;
+};
+
+}  // namespace hl_monitoring
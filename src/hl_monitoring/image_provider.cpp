@@ -2,11 +2,13 @@
 
 #include <hl_communication/utils.h>
 
+#include <algorithm>
+
 using namespace hl_communication;
 
 namespace hl_monitoring
 {
-ImageProvider::ImageProvider() : index(-1), nb_frames(0)
+ImageProvider::ImageProvider() : index(-1), nb_frames(0), undistortion(false)
 {
 }
 
@@ -19,18 +21,38 @@ CalibratedImage ImageProvider::getCalibratedImage(uint64_t time_stamp, bool syst
   return getCalibratedImage(time_stamp);
 }
 
+CalibratedImage ImageProvider::getImage(uint64_t time_stamp)
+{
+  CalibratedImage img = getCalibratedImage(time_stamp);
+  if (undistortion)
+  {
+    return img.getUndistorted();
+  }
+  return img;
+}
+
+void ImageProvider::setUndistortion(bool enabled)
+{
+  undistortion = enabled;
+}
+
+bool ImageProvider::isUndistortionEnabled() const
+{
+  return undistortion;
+}
+
 uint64_t ImageProvider::getStart() const
 {
-  if (indices_by_time_stamp.size() == 0)
+  if (time_stamp_index.empty())
     return 0;
-  return indices_by_time_stamp.begin()->first;
+  return time_stamp_index.getStart();
 }
 
 uint64_t ImageProvider::getEnd() const
 {
-  if (indices_by_time_stamp.size() == 0)
+  if (time_stamp_index.empty())
     return 0;
-  return indices_by_time_stamp.rbegin()->first;
+  return time_stamp_index.getEnd();
 }
 
 size_t ImageProvider::getNbFrames() const
@@ -38,29 +60,51 @@ size_t ImageProvider::getNbFrames() const
   return nb_frames;
 }
 
+uint64_t ImageProvider::getNbDroppedFrames() const
+{
+  return 0;
+}
+
+std::string ImageProvider::getOutputVideoPath() const
+{
+  return "";
+}
+
 void ImageProvider::setIntrinsic(const IntrinsicParameters& params)
 {
   meta_information.mutable_camera_parameters()->CopyFrom(params);
+  invalidateCameraMetaInformation();
+  onHeaderChange();
 }
 
 void ImageProvider::setDefaultPose(const Pose3D& pose)
 {
   meta_information.mutable_default_pose()->CopyFrom(pose);
+  invalidateCameraMetaInformation();
+  onHeaderChange();
 }
 
 void ImageProvider::setPose(int frame_idx, const Pose3D& pose)
 {
-  meta_information.mutable_frames(frame_idx)->mutable_pose()->CopyFrom(pose);
+  FrameEntry* entry = meta_information.mutable_frames(getFramePosition(frame_idx));
+  entry->mutable_pose()->CopyFrom(pose);
+  {
+    std::lock_guard<std::mutex> lock(camera_meta_mutex);
+    frame_camera_metas.erase(frame_idx);
+  }
+  onFrameChange(*entry);
 }
 
 void ImageProvider::setExternalName(const std::string& source_name)
 {
   meta_information.mutable_source_id()->set_external_source(source_name);
+  onHeaderChange();
 }
 
 void ImageProvider::setOffset(int64 offset)
 {
   meta_information.set_time_offset(offset);
+  onHeaderChange();
 }
 
 int64 ImageProvider::getOffset() const
@@ -84,26 +128,42 @@ CameraMetaInformation ImageProvider::getCameraMetaInformation() const
 
 CameraMetaInformation ImageProvider::getCameraMetaInformation(int index) const
 {
-  CameraMetaInformation camera_meta;
-  if (meta_information.has_camera_parameters())
-  {
-    camera_meta.mutable_camera_parameters()->CopyFrom(meta_information.camera_parameters());
-  }
-  if (meta_information.frames_size() <= index)
-  {
-    throw std::out_of_range(HL_DEBUG + "invalid index: " + std::to_string(index));
-  }
+  return *getSharedCameraMetaInformation(index);
+}
 
-  const FrameEntry& frame = meta_information.frames(index);
-  if (frame.has_pose())
+std::shared_ptr<const CameraMetaInformation> ImageProvider::getSharedCameraMetaInformation(int index) const
+{
+  const FrameEntry& frame = meta_information.frames(getFramePosition(index));
+  std::lock_guard<std::mutex> lock(camera_meta_mutex);
+  if (!frame.has_pose())
   {
-    camera_meta.mutable_pose()->CopyFrom(frame.pose());
+    if (!default_camera_meta)
+    {
+      std::shared_ptr<CameraMetaInformation> camera_meta = std::make_shared<CameraMetaInformation>();
+      if (meta_information.has_camera_parameters())
+      {
+        camera_meta->mutable_camera_parameters()->CopyFrom(meta_information.camera_parameters());
+      }
+      if (meta_information.has_default_pose())
+      {
+        camera_meta->mutable_pose()->CopyFrom(meta_information.default_pose());
+      }
+      default_camera_meta = std::move(camera_meta);
+    }
+    return default_camera_meta;
   }
-  else if (meta_information.has_default_pose())
+  std::shared_ptr<const CameraMetaInformation>& frame_meta = frame_camera_metas[index];
+  if (!frame_meta)
   {
-    camera_meta.mutable_pose()->CopyFrom(meta_information.default_pose());
+    std::shared_ptr<CameraMetaInformation> camera_meta = std::make_shared<CameraMetaInformation>();
+    if (meta_information.has_camera_parameters())
+    {
+      camera_meta->mutable_camera_parameters()->CopyFrom(meta_information.camera_parameters());
+    }
+    camera_meta->mutable_pose()->CopyFrom(frame.pose());
+    frame_meta = std::move(camera_meta);
   }
-  return camera_meta;
+  return frame_meta;
 }
 
 uint64_t ImageProvider::getTimeStamp() const
@@ -113,33 +173,87 @@ uint64_t ImageProvider::getTimeStamp() const
 
 uint64_t ImageProvider::getTimeStamp(int idx) const
 {
-  return time_stamp_by_index.at(idx);
+  return time_stamp_index.getTimeStamp(idx);
 }
 
 const FrameEntry& ImageProvider::getFrameEntry(uint64_t ts)
 {
   int idx = getIndex(ts);
-  return meta_information.frames(idx);
+  return meta_information.frames(getFramePosition(idx));
+}
+
+void ImageProvider::discardFramesBefore(uint64_t time_stamp)
+{
+  int first_kept = getIndex(time_stamp);
+  if (index >= 0)
+  {
+    first_kept = std::min(first_kept, index);
+  }
+  int nb_discarded = first_kept - getFirstFrameIndex();
+  if (nb_discarded <= 0)
+  {
+    return;
+  }
+  meta_information.mutable_frames()->DeleteSubrange(0, nb_discarded);
+  time_stamp_index.eraseBefore(first_kept);
+  std::lock_guard<std::mutex> lock(camera_meta_mutex);
+  for (auto it = frame_camera_metas.begin(); it != frame_camera_metas.end();)
+  {
+    if (it->first < first_kept)
+    {
+      it = frame_camera_metas.erase(it);
+    }
+    else
+    {
+      it++;
+    }
+  }
+}
+
+int ImageProvider::getFirstFrameIndex() const
+{
+  return time_stamp_index.getFirstIndex();
+}
+
+int ImageProvider::getFramePosition(int frame_index) const
+{
+  int position = frame_index - getFirstFrameIndex();
+  if (frame_index < 0 || position < 0 || position >= meta_information.frames_size())
+  {
+    throw std::out_of_range(HL_DEBUG + "invalid index: " + std::to_string(frame_index));
+  }
+  return position;
 }
 
 void ImageProvider::pushTimeStamp(int idx, uint64_t time_stamp)
 {
-  indices_by_time_stamp[time_stamp] = idx;
-  time_stamp_by_index[idx] = time_stamp;
+  time_stamp_index.push(idx, time_stamp);
+}
+
+void ImageProvider::invalidateCameraMetaInformation()
+{
+  std::lock_guard<std::mutex> lock(camera_meta_mutex);
+  default_camera_meta.reset();
+  frame_camera_metas.clear();
+}
+
+void ImageProvider::onHeaderChange()
+{
+}
+
+void ImageProvider::onFrameChange(const FrameEntry& entry)
+{
+  (void)entry;
 }
 
 int ImageProvider::getIndex(uint64_t time_stamp) const
 {
-  if (indices_by_time_stamp.size() == 0 || indices_by_time_stamp.begin()->first > time_stamp)
+  int idx = time_stamp_index.getIndex(time_stamp);
+  if (idx < 0)
   {
     return -1;
   }
-  auto it = indices_by_time_stamp.upper_bound(time_stamp);
-  if (it == indices_by_time_stamp.end() || it->first > time_stamp)
-  {
-    it--;
-  }
-  return std::min(nb_frames - 1, it->second);
+  return std::min(nb_frames - 1, idx);
 }
 
 }  // namespace hl_monitoring
@@ -1,6 +1,11 @@
 #pragma once
 
 #include "hl_monitoring/calibrated_image.h"
+#include "hl_monitoring/time_stamp_index.h"
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 namespace hl_monitoring
 {
@@ -30,6 +35,18 @@ public:
    */
   CalibratedImage getCalibratedImage(uint64_t time_stamp, bool system_clock);
 
+  /**
+   * Return the image for the given time_stamp according to the mode of the provider: undistorted with the default
+   * Undistorter if undistortion is enabled, as provided by getCalibratedImage otherwise
+   */
+  CalibratedImage getImage(uint64_t time_stamp);
+
+  /**
+   * Enable or disable the undistortion of the images returned by getImage
+   */
+  void setUndistortion(bool enabled);
+  bool isUndistortionEnabled() const;
+
   /**
    * For livestream, receive images from the stream
    */
@@ -63,6 +80,16 @@ public:
    */
   virtual size_t getNbFrames() const;
 
+  /**
+   * Number of frames lost by the provider since its creation, either while acquiring or while writing them
+   */
+  virtual uint64_t getNbDroppedFrames() const;
+
+  /**
+   * Path of the video recorded by the provider, empty if the provider does not record its images
+   */
+  virtual std::string getOutputVideoPath() const;
+
   virtual void setIntrinsic(const hl_communication::IntrinsicParameters& params);
   virtual void setDefaultPose(const hl_communication::Pose3D& pose);
   virtual void setPose(int frame_idx, const hl_communication::Pose3D& pose);
@@ -105,32 +132,67 @@ public:
    */
   hl_communication::CameraMetaInformation getCameraMetaInformation(int index) const;
 
+  /**
+   * Retrieve a shared handle on the meta information corresponding to the given img index. All the frames without a
+   * specific pose share the same handle, handles are only built again when the parameters change.
+   */
+  std::shared_ptr<const hl_communication::CameraMetaInformation> getSharedCameraMetaInformation(int index) const;
+
   /**
    * Return the index of the last entry before given time_stamp, if there are no
    * entry before this time_stamp, returns -1
    */
   int getIndex(uint64_t time_stamp) const;
 
+  /**
+   * Forget the frames received before time_stamp to bound memory usage, the frame valid at time_stamp and the current
+   * frame are always kept. Indices of the remaining frames are not modified.
+   */
+  void discardFramesBefore(uint64_t time_stamp);
+
+  /**
+   * Index of the oldest frame for which information is still available
+   */
+  int getFirstFrameIndex() const;
+
 protected:
   /**
-   * Push a new entry, updating both indices_by_time_stamp and time_stamp_by_index
+   * Return the position in meta_information.frames of the frame with the given index, throws std::out_of_range if the
+   * frame is not available
+   */
+  int getFramePosition(int frame_index) const;
+
+  /**
+   * Push a new entry in time_stamp_index, index has to be the number of entries already pushed
    */
   void pushTimeStamp(int index, uint64_t time_stamp);
 
   /**
-   * Information relevant to the video stream
+   * Discard the shared camera meta information, has to be called when meta_information is modified directly
    */
-  hl_communication::VideoMetaInformation meta_information;
+  void invalidateCameraMetaInformation();
 
   /**
-   * Provide access to indices based on monotonic time_stamps
+   * Called when the information shared by all the frames of meta_information is modified (camera parameters, default
+   * pose, source or offset), allows providers to save it. Default implementation does nothing.
    */
-  std::map<uint64_t, int> indices_by_time_stamp;
+  virtual void onHeaderChange();
 
   /**
-   * Provide access to monotonic time_stamp based on index
+   * Called when an entry of meta_information.frames is modified, allows providers which already saved the entry to
+   * save it again. Default implementation does nothing.
    */
-  std::map<int, uint64_t> time_stamp_by_index;
+  virtual void onFrameChange(const hl_communication::FrameEntry& entry);
+
+  /**
+   * Information relevant to the video stream, frames[i] describes the frame with index getFirstFrameIndex() + i
+   */
+  hl_communication::VideoMetaInformation meta_information;
+
+  /**
+   * Provide access to indices based on monotonic time_stamps and to monotonic time_stamps based on indices
+   */
+  TimeStampIndex time_stamp_index;
 
   /**
    * Index of the next image read in the video
@@ -141,6 +203,27 @@ protected:
    * The number of frames in the video
    */
   int nb_frames;
+
+private:
+  /**
+   * Are images returned by getImage undistorted
+   */
+  bool undistortion;
+
+  /**
+   * Protects the shared camera meta information
+   */
+  mutable std::mutex camera_meta_mutex;
+
+  /**
+   * Meta information for frames without specific pose, built on first use
+   */
+  mutable std::shared_ptr<const hl_communication::CameraMetaInformation> default_camera_meta;
+
+  /**
+   * Meta information for frames with a specific pose, built on first use
+   */
+  mutable std::unordered_map<int, std::shared_ptr<const hl_communication::CameraMetaInformation>> frame_camera_metas;
 };
 
 }  // namespace hl_monitoring
@@ -0,0 +1,104 @@
+#include "hl_monitoring/image_provider_factory.h"
+
+#include <hl_communication/utils.h>
+
+using namespace hl_communication;
+
+namespace hl_monitoring
+{
+ImageProviderFactory::Capabilities::Capabilities()
+  : live(true), seekable(false), async_capture(false)
+{
+}
+
+ImageProviderFactory::Capabilities::Capabilities(bool live_, bool seekable_, bool async_capture_)
+  : live(live_), seekable(seekable_), async_capture(async_capture_)
+{
+}
+
+Json::Value ImageProviderFactory::Capabilities::toJson() const
+{
+  Json::Value v;
+  v["live"] = live;
+  v["seekable"] = seekable;
+  v["async_capture"] = async_capture;
+  return v;
+}
+
+ImageProviderFactory::Registrar::Registrar(const std::string& class_name, Builder builder,
+                                           const Capabilities& capabilities)
+{
+  ImageProviderFactory::getDefault().registerClass(class_name, std::move(builder), capabilities);
+}
+
+void ImageProviderFactory::registerClass(const std::string& class_name, Builder builder,
+                                         const Capabilities& capabilities)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (entries.count(class_name) > 0)
+  {
+    throw std::logic_error(HL_DEBUG + " class '" + class_name + "' is already registered");
+  }
+  entries[class_name] = { std::move(builder), capabilities };
+}
+
+bool ImageProviderFactory::isRegistered(const std::string& class_name) const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return entries.count(class_name) > 0;
+}
+
+ImageProviderFactory::Capabilities ImageProviderFactory::getCapabilities(const std::string& class_name) const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = entries.find(class_name);
+  if (it == entries.end())
+  {
+    throw std::out_of_range(HL_DEBUG + " unknown class: '" + class_name + "'");
+  }
+  return it->second.capabilities;
+}
+
+std::vector<std::string> ImageProviderFactory::getClassNames() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  std::vector<std::string> class_names;
+  for (const auto& entry : entries)
+  {
+    class_names.push_back(entry.first);
+  }
+  return class_names;
+}
+
+std::unique_ptr<ImageProvider> ImageProviderFactory::build(const Json::Value& v, const BuildContext& context) const
+{
+  checkMember(v, "class_name");
+  std::string class_name;
+  readVal(v, "class_name", &class_name);
+  Entry entry;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = entries.find(class_name);
+    if (it == entries.end())
+    {
+      throw std::runtime_error(HL_DEBUG + "unknown class: '" + class_name + "'");
+    }
+    entry = it->second;
+  }
+  bool async_capture = false;
+  tryReadVal(v, "async_capture", &async_capture);
+  if (async_capture && !entry.capabilities.async_capture)
+  {
+    throw std::runtime_error(HL_DEBUG + " class '" + class_name + "' does not support asynchronous capture");
+  }
+  // Builder is called without holding the lock, so that it can use the factory
+  return entry.builder(v, context);
+}
+
+ImageProviderFactory& ImageProviderFactory::getDefault()
+{
+  static ImageProviderFactory factory;
+  return factory;
+}
+
+}  // namespace hl_monitoring
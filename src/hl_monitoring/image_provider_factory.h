@@ -0,0 +1,115 @@
+#pragma once
+
+#include "hl_monitoring/field.h"
+#include "hl_monitoring/image_provider.h"
+
+#include <json/json.h>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace hl_monitoring
+{
+/**
+ * Registry of the classes of image providers which can be built from a json configuration.
+ *
+ * Each class registers a builder along with its capabilities, usually through a static Registrar declared in its
+ * source file, so that new providers are available without modifying the MonitoringManager. Capabilities allow the
+ * manager to choose how each provider is scheduled.
+ */
+class ImageProviderFactory
+{
+public:
+  struct Capabilities
+  {
+    /**
+     * Default capabilities are the ones assumed for unknown providers: they are updated and accessed only when
+     * required
+     */
+    Capabilities();
+    Capabilities(bool live, bool seekable, bool async_capture);
+
+    /**
+     * Images are acquired while running, update has to be called regularly
+     */
+    bool live;
+
+    /**
+     * Any frame still available can be retrieved at any time, frames can therefore be requested in advance
+     */
+    bool seekable;
+
+    /**
+     * Acquisition can run in a dedicated thread, see 'async_capture' in the configuration
+     */
+    bool async_capture;
+
+    Json::Value toJson() const;
+  };
+
+  /**
+   * Information from the manager available to the builders
+   */
+  struct BuildContext
+  {
+    /**
+     * Prefix of the files written by the provider, empty if nothing should be written
+     */
+    std::string output_prefix;
+
+    const Field* field;
+  };
+
+  typedef std::function<std::unique_ptr<ImageProvider>(const Json::Value& v, const BuildContext& context)> Builder;
+
+  /**
+   * Registers a class when constructed, meant to be declared as a static variable
+   */
+  class Registrar
+  {
+  public:
+    Registrar(const std::string& class_name, Builder builder, const Capabilities& capabilities);
+  };
+
+  /**
+   * Throws a logic_error if a class with the same name is already registered
+   */
+  void registerClass(const std::string& class_name, Builder builder, const Capabilities& capabilities);
+
+  bool isRegistered(const std::string& class_name) const;
+
+  /**
+   * Throws an out_of_range exception if class_name is not registered
+   */
+  Capabilities getCapabilities(const std::string& class_name) const;
+
+  std::vector<std::string> getClassNames() const;
+
+  /**
+   * Build the provider described in v, the class is read from the 'class_name' member. Throws a runtime_error if the
+   * class is unknown or if the configuration requires a capability that the class does not have.
+   */
+  std::unique_ptr<ImageProvider> build(const Json::Value& v, const BuildContext& context) const;
+
+  /**
+   * Registry used by the MonitoringManager, contains all the classes compiled in the library
+   */
+  static ImageProviderFactory& getDefault();
+
+private:
+  struct Entry
+  {
+    Builder builder;
+    Capabilities capabilities;
+  };
+
+  mutable std::mutex mutex;
+
+  std::map<std::string, Entry> entries;
+};
+
+}  // namespace hl_monitoring
@@ -0,0 +1,274 @@
+#include "hl_monitoring/jpeg_chunk_log.h"
+
+#include <hl_communication/utils.h>
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <iostream>
+
+using namespace hl_communication;
+
+namespace hl_monitoring
+{
+const std::string jpeg_chunk_extension("jpegs");
+
+/**
+ * Starts the offset table, allows to detect files which are not offset tables
+ */
+static const std::string magic("\0hljpeg1", 8);
+
+/**
+ * Size of an entry of the offset table [bytes]
+ */
+static const size_t entry_size = 12;
+
+static void writeLittleEndian(uint64_t value, int nb_bytes, char* buffer)
+{
+  for (int idx = 0; idx < nb_bytes; idx++)
+  {
+    buffer[idx] = (char)((value >> (8 * idx)) & 0xff);
+  }
+}
+
+static uint64_t readLittleEndian(const unsigned char* buffer, int nb_bytes)
+{
+  uint64_t value = 0;
+  for (int idx = nb_bytes - 1; idx >= 0; idx--)
+  {
+    value = (value << 8) | buffer[idx];
+  }
+  return value;
+}
+
+bool isJpegChunkPath(const std::string& path)
+{
+  const std::string suffix = "." + jpeg_chunk_extension;
+  return path.size() > suffix.size() && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+std::string getJpegOffsetsPath(const std::string& chunk_path)
+{
+  std::string prefix = chunk_path;
+  if (isJpegChunkPath(chunk_path))
+  {
+    prefix = chunk_path.substr(0, chunk_path.size() - jpeg_chunk_extension.size() - 1);
+  }
+  return prefix + ".offsets";
+}
+
+JpegChunkWriter::JpegChunkWriter() : data_size(0), nb_frames(0), quality(90)
+{
+}
+
+JpegChunkWriter::~JpegChunkWriter()
+{
+  close();
+}
+
+void JpegChunkWriter::open(const std::string& new_path)
+{
+  if (isOpened())
+  {
+    throw std::logic_error(HL_DEBUG + " jpeg chunk writer is already opened");
+  }
+  std::string offsets_path = getJpegOffsetsPath(new_path);
+  data.open(new_path, std::ios::binary | std::ios::trunc);
+  offsets.open(offsets_path, std::ios::binary | std::ios::trunc);
+  if (!data.good() || !offsets.good())
+  {
+    close();
+    throw std::runtime_error(HL_DEBUG + "Failed to open files '" + new_path + "' and '" + offsets_path + "'");
+  }
+  path = new_path;
+  data_size = 0;
+  nb_frames = 0;
+  offsets.write(magic.data(), magic.size());
+  offsets.flush();
+}
+
+bool JpegChunkWriter::isOpened() const
+{
+  return data.is_open();
+}
+
+void JpegChunkWriter::close()
+{
+  if (data.is_open())
+  {
+    data.close();
+  }
+  if (offsets.is_open())
+  {
+    offsets.close();
+  }
+}
+
+void JpegChunkWriter::setQuality(int new_quality)
+{
+  if (new_quality < 0 || new_quality > 100)
+  {
+    throw std::out_of_range(HL_DEBUG + " invalid jpeg quality: " + std::to_string(new_quality));
+  }
+  quality = new_quality;
+}
+
+int JpegChunkWriter::getQuality() const
+{
+  return quality;
+}
+
+void JpegChunkWriter::write(const cv::Mat& img)
+{
+  if (!isOpened())
+  {
+    throw std::logic_error(HL_DEBUG + " jpeg chunk writer is not opened");
+  }
+  std::vector<uchar> buffer;
+  if (!cv::imencode(".jpg", img, buffer, { cv::IMWRITE_JPEG_QUALITY, quality }))
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to encode image for '" + path + "'");
+  }
+  uint64_t offset = data_size;
+  data.write((const char*)buffer.data(), buffer.size());
+  data.flush();
+  if (!data.good())
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to write image in '" + path + "'");
+  }
+  // The image is in the chunk file, offsets of the next images have to account for it even if its entry is lost
+  data_size += buffer.size();
+  // The entry is only written once the image is available in the chunk file
+  char entry[entry_size];
+  writeLittleEndian(offset, 8, entry);
+  writeLittleEndian(buffer.size(), 4, entry + 8);
+  offsets.write(entry, entry_size);
+  offsets.flush();
+  if (!offsets.good())
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to write offset table of '" + path + "'");
+  }
+  nb_frames++;
+}
+
+int JpegChunkWriter::getNbFrames() const
+{
+  return nb_frames;
+}
+
+JpegChunkReader::JpegChunkReader()
+{
+}
+
+void JpegChunkReader::open(const std::string& new_path)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (data.is_open())
+  {
+    data.close();
+  }
+  chunks.clear();
+  std::string offsets_path = getJpegOffsetsPath(new_path);
+  std::ifstream offsets(offsets_path, std::ios::binary);
+  if (!offsets.good())
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to open offset table '" + offsets_path + "'");
+  }
+  std::string read_magic(magic.size(), ' ');
+  if (!offsets.read(&read_magic[0], magic.size()) || read_magic != magic)
+  {
+    throw std::runtime_error(HL_DEBUG + "Invalid offset table '" + offsets_path + "'");
+  }
+  data.open(new_path, std::ios::binary | std::ios::ate);
+  if (!data.good())
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to open jpeg chunk file '" + new_path + "'");
+  }
+  uint64_t data_size = data.tellg();
+  unsigned char entry[entry_size];
+  while (offsets.read((char*)entry, entry_size))
+  {
+    Chunk chunk;
+    chunk.offset = readLittleEndian(entry, 8);
+    chunk.size = readLittleEndian(entry + 8, 4);
+    if (chunk.offset + chunk.size > data_size)
+    {
+      std::cerr << HL_DEBUG << "ignoring entries of '" << offsets_path << "' after frame " << chunks.size()
+                << ": data is missing in '" << new_path << "'" << std::endl;
+      break;
+    }
+    chunks.push_back(chunk);
+  }
+  if (offsets.gcount() != 0 && offsets.gcount() != (std::streamsize)entry_size)
+  {
+    std::cerr << HL_DEBUG << "ignoring incomplete entry at the end of '" << offsets_path << "'" << std::endl;
+  }
+  path = new_path;
+}
+
+bool JpegChunkReader::isOpened() const
+{
+  return data.is_open();
+}
+
+void JpegChunkReader::close()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (data.is_open())
+  {
+    data.close();
+  }
+  chunks.clear();
+}
+
+int JpegChunkReader::getNbFrames() const
+{
+  return chunks.size();
+}
+
+cv::Mat JpegChunkReader::read(int frame_index, int reduction)
+{
+  int flags;
+  switch (reduction)
+  {
+    case 1:
+      flags = cv::IMREAD_COLOR;
+      break;
+    case 2:
+      flags = cv::IMREAD_REDUCED_COLOR_2;
+      break;
+    case 4:
+      flags = cv::IMREAD_REDUCED_COLOR_4;
+      break;
+    case 8:
+      flags = cv::IMREAD_REDUCED_COLOR_8;
+      break;
+    default:
+      throw std::out_of_range(HL_DEBUG + " invalid reduction: " + std::to_string(reduction));
+  }
+  if (frame_index < 0 || frame_index >= (int)chunks.size())
+  {
+    throw std::out_of_range(HL_DEBUG + "invalid frame index: " + std::to_string(frame_index) + "/" +
+                            std::to_string(chunks.size()));
+  }
+  const Chunk& chunk = chunks[frame_index];
+  std::vector<uchar> buffer(chunk.size);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    data.clear();
+    data.seekg(chunk.offset);
+    if (!data.read((char*)buffer.data(), chunk.size))
+    {
+      throw std::runtime_error(HL_DEBUG + "Failed to read frame " + std::to_string(frame_index) + " in '" + path +
+                               "'");
+    }
+  }
+  cv::Mat img = cv::imdecode(buffer, flags);
+  if (img.empty())
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to decode frame " + std::to_string(frame_index) + " in '" + path +
+                             "'");
+  }
+  return img;
+}
+
+}  // namespace hl_monitoring
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace hl_monitoring
+{
+/**
+ * Extension of the files written by JpegChunkWriter, can be used as the container of a VideoWriterStage
+ */
+extern const std::string jpeg_chunk_extension;
+
+/**
+ * Return true if the path designates a JPEG chunk file, based on its extension
+ */
+bool isJpegChunkPath(const std::string& path);
+
+/**
+ * Return the path of the offset table associated to a JPEG chunk file: '<prefix>.jpegs' -> '<prefix>.offsets'
+ */
+std::string getJpegOffsetsPath(const std::string& chunk_path);
+
+/**
+ * Writes images as a sequence of independent JPEG images, so that any frame can be read with a single seek and a single
+ * decode, at the cost of larger files than with inter-frame codecs.
+ *
+ * The chunk file is the concatenation of the JPEG images. The offset table is written in a separate file, it starts
+ * with a magic sequence followed by the position [bytes, uint64] and the size [bytes, uint32] of each image, in
+ * little-endian. Both files are flushed after each image, so that images already written are not lost if the program
+ * stops unexpectedly.
+ */
+class JpegChunkWriter
+{
+public:
+  JpegChunkWriter();
+  ~JpegChunkWriter();
+
+  JpegChunkWriter(const JpegChunkWriter& other) = delete;
+  JpegChunkWriter& operator=(const JpegChunkWriter& other) = delete;
+
+  /**
+   * Create the chunk file and its offset table, throws a runtime_error on failure
+   */
+  void open(const std::string& path);
+
+  bool isOpened() const;
+
+  void close();
+
+  /**
+   * Quality of the JPEG encoding in [0, 100], used for the next images
+   */
+  void setQuality(int quality);
+  int getQuality() const;
+
+  /**
+   * Encode the image and append it to the chunk file, throws a runtime_error on failure
+   */
+  void write(const cv::Mat& img);
+
+  int getNbFrames() const;
+
+private:
+  std::ofstream data;
+
+  std::ofstream offsets;
+
+  /**
+   * Number of bytes written in the chunk file
+   */
+  uint64_t data_size;
+
+  int nb_frames;
+
+  int quality;
+
+  std::string path;
+};
+
+/**
+ * Random access to the images of a file written by JpegChunkWriter. Reading is thread-safe and decoding is done
+ * without holding the lock, so that several threads can decode images simultaneously.
+ */
+class JpegChunkReader
+{
+public:
+  JpegChunkReader();
+
+  JpegChunkReader(const JpegChunkReader& other) = delete;
+  JpegChunkReader& operator=(const JpegChunkReader& other) = delete;
+
+  /**
+   * Open the chunk file and load its offset table, throws a runtime_error on failure. Entries referring to data which
+   * is not available in the chunk file are ignored and a warning is printed.
+   */
+  void open(const std::string& path);
+
+  bool isOpened() const;
+
+  void close();
+
+  int getNbFrames() const;
+
+  /**
+   * Read and decode the image at the given index. If reduction is 2, 4 or 8, the image is decoded directly at a
+   * reduced resolution, which is significantly cheaper than decoding the full image.
+   * Throws an out_of_range if the index or the reduction is invalid and a runtime_error if decoding fails.
+   */
+  cv::Mat read(int frame_index, int reduction = 1);
+
+private:
+  struct Chunk
+  {
+    /**
+     * Position of the image in the chunk file [bytes]
+     */
+    uint64_t offset;
+
+    /**
+     * Size of the image [bytes]
+     */
+    uint32_t size;
+  };
+
+  /**
+   * Protects access to 'data', the offset table is not modified while the reader is opened
+   */
+  std::mutex mutex;
+
+  std::ifstream data;
+
+  std::vector<Chunk> chunks;
+
+  std::string path;
+};
+
+}  // namespace hl_monitoring
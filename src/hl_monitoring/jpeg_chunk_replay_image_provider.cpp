@@ -0,0 +1,128 @@
+#include "hl_monitoring/jpeg_chunk_replay_image_provider.h"
+#include "hl_monitoring/image_provider_factory.h"
+#include "hl_monitoring/meta_information_log.h"
+
+#include <hl_communication/utils.h>
+
+#include <iostream>
+
+using namespace hl_communication;
+
+namespace hl_monitoring
+{
+static std::unique_ptr<ImageProvider> buildJpegChunkReplayImageProvider(
+    const Json::Value& v, const ImageProviderFactory::BuildContext& context)
+{
+  std::string input_path, meta_information_path;
+  checkMember(v, "input_path");
+  checkMember(v, "meta_information_path");
+  readVal(v, "input_path", &input_path);
+  readVal(v, "meta_information_path", &meta_information_path);
+  return std::unique_ptr<ImageProvider>(new JpegChunkReplayImageProvider(input_path, meta_information_path));
+}
+
+static ImageProviderFactory::Registrar registrar("JpegChunkReplayImageProvider", buildJpegChunkReplayImageProvider,
+                                                 ImageProviderFactory::Capabilities(false, true, false));
+
+JpegChunkReplayImageProvider::JpegChunkReplayImageProvider(const std::string& chunk_path,
+                                                           const std::string& meta_information_path)
+{
+  reader.open(chunk_path);
+  loadMetaInformation(meta_information_path);
+}
+
+void JpegChunkReplayImageProvider::loadMetaInformation(const std::string& meta_information_path)
+{
+  readMetaInformation(meta_information_path, &meta_information);
+  invalidateCameraMetaInformation();
+  index = 0;
+  nb_frames = meta_information.frames_size();
+  if (nb_frames > reader.getNbFrames())
+  {
+    // Entries are written after the images, this only happens if the chunk file is damaged
+    std::cerr << HL_DEBUG << "ignoring the last " << (nb_frames - reader.getNbFrames()) << " entries of '"
+              << meta_information_path << "': images are missing" << std::endl;
+    nb_frames = reader.getNbFrames();
+  }
+  time_stamp_index.clear();
+  time_stamp_index.reserve(nb_frames);
+  for (int idx = 0; idx < nb_frames; idx++)
+  {
+    uint64_t time_stamp = getTS(meta_information.frames(idx), true);
+    if (time_stamp_index.hasTimeStamp(time_stamp))
+    {
+      throw std::runtime_error(HL_DEBUG + "Duplicated time_stamp " + std::to_string(time_stamp));
+    }
+    pushTimeStamp(idx, time_stamp);
+  }
+}
+
+void JpegChunkReplayImageProvider::restartStream()
+{
+  setIndex(0);
+}
+
+CalibratedImage JpegChunkReplayImageProvider::getCalibratedImage(uint64_t time_stamp)
+{
+  int new_index = getIndex(time_stamp);
+  cv::Mat img;
+  if (new_index == -1)
+  {
+    return CalibratedImage();
+  }
+  else if (new_index == index - 1 && !last_img.empty())  // Asking for previous image again
+  {
+    img = last_img;
+  }
+  else
+  {
+    img = reader.read(new_index);
+    last_img = img;
+    index = new_index + 1;
+  }
+  return CalibratedImage(img, getSharedCameraMetaInformation(new_index));
+}
+
+cv::Mat JpegChunkReplayImageProvider::getNextImg()
+{
+  if (isStreamFinished())
+  {
+    throw std::logic_error("Asking for a new frame while stream is finished");
+  }
+  last_img = reader.read(index);
+  index++;
+  return last_img;
+}
+
+void JpegChunkReplayImageProvider::update()
+{
+  // Nothing required
+}
+
+bool JpegChunkReplayImageProvider::isStreamFinished()
+{
+  return index >= nb_frames;
+}
+
+void JpegChunkReplayImageProvider::setIndex(int new_index)
+{
+  if (new_index < 0 || new_index > nb_frames)
+  {
+    throw std::out_of_range(HL_DEBUG + "Failed to set index to " + std::to_string(new_index) + " in video");
+  }
+  // last_img does not match the previous index anymore, reading a frame only requires a single decode anyway
+  last_img = cv::Mat();
+  index = new_index;
+}
+
+cv::Mat JpegChunkReplayImageProvider::getThumbnail(uint64_t time_stamp, int reduction)
+{
+  int frame_index = getIndex(time_stamp);
+  if (frame_index == -1)
+  {
+    return cv::Mat();
+  }
+  return reader.read(frame_index, reduction);
+}
+
+}  // namespace hl_monitoring
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "hl_monitoring/image_provider.h"
+#include "hl_monitoring/jpeg_chunk_log.h"
+
+namespace hl_monitoring
+{
+/**
+ * Provides images from a JPEG chunk file written during a live recording, see JpegChunkWriter.
+ *
+ * Since all images are encoded independently, accessing any frame requires a single seek and a single decode, the
+ * cost of scrubbing or playing backward is therefore the same as the cost of playing forward. Thumbnails can be decoded
+ * directly at a reduced resolution.
+ *
+ * Frame i of the chunk file is described by the entry i of the meta information.
+ */
+class JpegChunkReplayImageProvider : public ImageProvider
+{
+public:
+  JpegChunkReplayImageProvider(const std::string& chunk_path, const std::string& meta_information_path);
+
+  void restartStream() override;
+
+  CalibratedImage getCalibratedImage(uint64_t time_stamp) override;
+
+  cv::Mat getNextImg() override;
+
+  void update() override;
+
+  bool isStreamFinished() override;
+
+  void setIndex(int index);
+
+  /**
+   * Return the image closest to the given time stamp decoded at a reduced resolution, reduction has to be 1, 2, 4 or 8.
+   * The current index is not modified, therefore thumbnails can be requested while playing. Returns an empty image if
+   * there is no frame at the given time stamp.
+   */
+  cv::Mat getThumbnail(uint64_t time_stamp, int reduction);
+
+private:
+  void loadMetaInformation(const std::string& meta_information_path);
+
+  JpegChunkReader reader;
+
+  /**
+   * The last image retrieved
+   */
+  cv::Mat last_img;
+};
+
+}  // namespace hl_monitoring
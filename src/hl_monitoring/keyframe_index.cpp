@@ -0,0 +1,388 @@
+#include "hl_monitoring/keyframe_index.h"
+
+#include <hl_communication/utils.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+using namespace hl_communication;
+
+namespace hl_monitoring
+{
+/**
+ * Flag of legacy index entries marking keyframes
+ */
+static const uint32_t AVIIF_KEYFRAME = 0x10;
+
+/**
+ * Bit of the size of standard index entries marking frames which are NOT keyframes
+ */
+static const uint32_t AVI_NOT_KEYFRAME = 0x80000000;
+
+static const uint8_t AVI_INDEX_OF_INDEXES = 0x00;
+static const uint8_t AVI_INDEX_OF_CHUNKS = 0x01;
+
+static uint64_t readLittleEndian(std::istream& in, int nb_bytes)
+{
+  unsigned char bytes[8];
+  if (!in.read((char*)bytes, nb_bytes))
+  {
+    throw std::runtime_error(HL_DEBUG + " unexpected end of file");
+  }
+  uint64_t value = 0;
+  for (int idx = nb_bytes - 1; idx >= 0; idx--)
+  {
+    value = (value << 8) | bytes[idx];
+  }
+  return value;
+}
+
+static uint32_t readU32(std::istream& in)
+{
+  return readLittleEndian(in, 4);
+}
+
+static std::string readFourCC(std::istream& in)
+{
+  char buffer[4];
+  if (!in.read(buffer, 4))
+  {
+    throw std::runtime_error(HL_DEBUG + " unexpected end of file");
+  }
+  return std::string(buffer, 4);
+}
+
+/**
+ * Return true if chunk_id designates a video chunk of the given stream, e.g. '00dc' or '00db'
+ */
+static bool isVideoChunk(const std::string& chunk_id, int stream_number)
+{
+  char stream_str[3];
+  snprintf(stream_str, sizeof(stream_str), "%02d", stream_number);
+  std::string type = chunk_id.substr(2);
+  return chunk_id.compare(0, 2, stream_str) == 0 && (type == "dc" || type == "db");
+}
+
+KeyframeIndex::KeyframeIndex() : nb_frames(0), video_size(0)
+{
+}
+
+bool KeyframeIndex::buildFromAvi(const std::string& video_path)
+{
+  clear();
+  std::ifstream in(video_path, std::ios::binary);
+  if (!in.good())
+  {
+    return false;
+  }
+  try
+  {
+    in.seekg(0, std::ios::end);
+    video_size = in.tellg();
+    in.seekg(0);
+    if (readFourCC(in) != "RIFF")
+    {
+      return false;
+    }
+    uint64_t riff_end = 8 + (uint64_t)readU32(in);
+    if (readFourCC(in) != "AVI ")
+    {
+      return false;
+    }
+    int stream_number = -1;
+    std::vector<uint64_t> standard_indices;
+    uint64_t movi_offset = 0;
+    uint64_t idx1_start = 0;
+    uint32_t idx1_size = 0;
+    // Only the first RIFF is required: it contains the headers and the legacy index
+    uint64_t pos = 12;
+    while (pos + 8 <= std::min(riff_end, video_size))
+    {
+      in.seekg(pos);
+      std::string chunk_id = readFourCC(in);
+      uint32_t chunk_size = readU32(in);
+      if (chunk_id == "LIST")
+      {
+        std::string list_type = readFourCC(in);
+        if (list_type == "hdrl")
+        {
+          parseHeaderList(in, pos + 12, pos + 8 + chunk_size, &stream_number, &standard_indices);
+        }
+        else if (list_type == "movi")
+        {
+          movi_offset = pos + 8;
+        }
+      }
+      else if (chunk_id == "idx1")
+      {
+        idx1_start = pos + 8;
+        idx1_size = chunk_size;
+      }
+      // Chunks are padded to an even size
+      pos += 8 + (uint64_t)chunk_size + (chunk_size & 1);
+    }
+    if (stream_number < 0)
+    {
+      return false;
+    }
+    if (standard_indices.size() > 0)
+    {
+      // OpenDML indices cover the whole file, legacy index only covers the first RIFF
+      for (uint64_t offset : standard_indices)
+      {
+        parseStandardIndex(in, offset);
+      }
+    }
+    else if (idx1_size > 0)
+    {
+      parseLegacyIndex(in, idx1_start, idx1_size, movi_offset, stream_number);
+    }
+  }
+  catch (const std::runtime_error& exc)
+  {
+    std::cerr << HL_DEBUG << "failed to parse AVI index of '" << video_path << "': " << exc.what() << std::endl;
+    clear();
+    return false;
+  }
+  return !empty();
+}
+
+bool KeyframeIndex::loadOrBuild(const std::string& video_path, const std::string& index_path)
+{
+  std::ifstream video_file(video_path, std::ios::binary | std::ios::ate);
+  uint64_t current_video_size = video_file.good() ? (uint64_t)video_file.tellg() : 0;
+  if (std::ifstream(index_path).good())
+  {
+    try
+    {
+      fromJson(file2Json(index_path));
+      if (video_size == current_video_size)
+      {
+        return !empty();
+      }
+    }
+    catch (const std::exception& exc)
+    {
+      std::cerr << HL_DEBUG << "ignoring invalid keyframe index '" << index_path << "': " << exc.what() << std::endl;
+    }
+  }
+  if (!buildFromAvi(video_path))
+  {
+    return false;
+  }
+  try
+  {
+    writeJson(toJson(), index_path, true);
+  }
+  catch (const std::exception& exc)
+  {
+    // Index is still usable, it will just be built again next time
+    std::cerr << HL_DEBUG << "failed to save keyframe index at '" << index_path << "': " << exc.what() << std::endl;
+  }
+  return true;
+}
+
+void KeyframeIndex::clear()
+{
+  keyframes.clear();
+  nb_frames = 0;
+  video_size = 0;
+}
+
+bool KeyframeIndex::empty() const
+{
+  return keyframes.empty();
+}
+
+int KeyframeIndex::getNbFrames() const
+{
+  return nb_frames;
+}
+
+const std::vector<KeyframeIndex::Keyframe>& KeyframeIndex::getKeyframes() const
+{
+  return keyframes;
+}
+
+int KeyframeIndex::getKeyframeBefore(int frame_index) const
+{
+  auto it = std::upper_bound(keyframes.begin(), keyframes.end(), frame_index,
+                             [](int idx, const Keyframe& keyframe) { return idx < keyframe.frame_index; });
+  if (it == keyframes.begin())
+  {
+    return 0;
+  }
+  it--;
+  return it->frame_index;
+}
+
+Json::Value KeyframeIndex::toJson() const
+{
+  Json::Value v;
+  v["video_size"] = (Json::UInt64)video_size;
+  v["nb_frames"] = nb_frames;
+  v["keyframes"] = Json::Value(Json::arrayValue);
+  for (const Keyframe& keyframe : keyframes)
+  {
+    Json::Value entry(Json::arrayValue);
+    entry.append(keyframe.frame_index);
+    entry.append((Json::UInt64)keyframe.offset);
+    entry.append(keyframe.size);
+    v["keyframes"].append(entry);
+  }
+  return v;
+}
+
+void KeyframeIndex::fromJson(const Json::Value& v)
+{
+  clear();
+  checkMember(v, "video_size");
+  checkMember(v, "nb_frames");
+  checkMember(v, "keyframes");
+  video_size = v["video_size"].asUInt64();
+  nb_frames = v["nb_frames"].asInt();
+  const Json::Value& entries = v["keyframes"];
+  if (!entries.isArray())
+  {
+    throw std::runtime_error(HL_DEBUG + " expecting an array for 'keyframes'");
+  }
+  for (Json::ArrayIndex idx = 0; idx < entries.size(); idx++)
+  {
+    const Json::Value& entry = entries[idx];
+    if (!entry.isArray() || entry.size() != 3)
+    {
+      throw std::runtime_error(HL_DEBUG + " invalid keyframe entry at index " + std::to_string(idx));
+    }
+    keyframes.push_back({ entry[0].asInt(), entry[1].asUInt64(), entry[2].asUInt() });
+  }
+}
+
+void KeyframeIndex::parseHeaderList(std::istream& in, uint64_t start, uint64_t end, int* stream_number,
+                                    std::vector<uint64_t>* standard_indices)
+{
+  *stream_number = -1;
+  int stream_counter = 0;
+  uint64_t pos = start;
+  while (pos + 8 <= end)
+  {
+    in.seekg(pos);
+    std::string chunk_id = readFourCC(in);
+    uint32_t chunk_size = readU32(in);
+    if (chunk_id == "LIST" && readFourCC(in) == "strl")
+    {
+      bool is_video = false;
+      uint64_t strl_end = pos + 8 + chunk_size;
+      uint64_t sub_pos = pos + 12;
+      while (sub_pos + 8 <= strl_end)
+      {
+        in.seekg(sub_pos);
+        std::string sub_id = readFourCC(in);
+        uint32_t sub_size = readU32(in);
+        if (sub_id == "strh")
+        {
+          is_video = readFourCC(in) == "vids" && *stream_number < 0;
+          if (is_video)
+          {
+            *stream_number = stream_counter;
+          }
+        }
+        else if (sub_id == "indx" && is_video)
+        {
+          // Super index: lists the position of the standard indices
+          uint16_t longs_per_entry = readLittleEndian(in, 2);
+          readLittleEndian(in, 1);  // index sub type
+          uint8_t index_type = readLittleEndian(in, 1);
+          uint32_t nb_entries = readU32(in);
+          if (index_type != AVI_INDEX_OF_INDEXES || longs_per_entry != 4)
+          {
+            throw std::runtime_error(HL_DEBUG + " unsupported super index");
+          }
+          in.seekg(4 + 12, std::ios::cur);  // chunk id + reserved
+          for (uint32_t entry = 0; entry < nb_entries; entry++)
+          {
+            standard_indices->push_back(readLittleEndian(in, 8));
+            in.seekg(8, std::ios::cur);  // size + duration
+          }
+        }
+        sub_pos += 8 + (uint64_t)sub_size + (sub_size & 1);
+      }
+      stream_counter++;
+    }
+    pos += 8 + (uint64_t)chunk_size + (chunk_size & 1);
+  }
+}
+
+void KeyframeIndex::parseStandardIndex(std::istream& in, uint64_t offset)
+{
+  in.seekg(offset);
+  readFourCC(in);  // ix## chunk id
+  readU32(in);     // chunk size
+  uint16_t longs_per_entry = readLittleEndian(in, 2);
+  readLittleEndian(in, 1);  // index sub type
+  uint8_t index_type = readLittleEndian(in, 1);
+  uint32_t nb_entries = readU32(in);
+  readFourCC(in);  // chunk id of the indexed stream
+  uint64_t base_offset = readLittleEndian(in, 8);
+  readU32(in);  // reserved
+  if (index_type != AVI_INDEX_OF_CHUNKS || longs_per_entry != 2)
+  {
+    throw std::runtime_error(HL_DEBUG + " unsupported standard index");
+  }
+  std::vector<char> buffer(8 * (size_t)nb_entries);
+  if (!in.read(buffer.data(), buffer.size()))
+  {
+    throw std::runtime_error(HL_DEBUG + " unexpected end of file");
+  }
+  for (uint32_t entry = 0; entry < nb_entries; entry++)
+  {
+    const unsigned char* data = (const unsigned char*)buffer.data() + 8 * entry;
+    uint32_t data_offset = data[0] | data[1] << 8 | data[2] << 16 | (uint32_t)data[3] << 24;
+    uint32_t size = data[4] | data[5] << 8 | data[6] << 16 | (uint32_t)data[7] << 24;
+    if (!(size & AVI_NOT_KEYFRAME))
+    {
+      // Offsets of standard indices point to the data, not to the chunk header
+      keyframes.push_back({ nb_frames, base_offset + data_offset - 8, size });
+    }
+    nb_frames++;
+  }
+}
+
+void KeyframeIndex::parseLegacyIndex(std::istream& in, uint64_t start, uint32_t size, uint64_t movi_offset,
+                                     int stream_number)
+{
+  uint32_t nb_entries = size / 16;
+  std::vector<char> buffer(16 * (size_t)nb_entries);
+  in.seekg(start);
+  if (!in.read(buffer.data(), buffer.size()))
+  {
+    throw std::runtime_error(HL_DEBUG + " unexpected end of file");
+  }
+  // Offsets are either relative to the 'movi' fourcc or absolute, depending on the muxer
+  bool relative_offsets = true;
+  for (uint32_t entry = 0; entry < nb_entries; entry++)
+  {
+    const unsigned char* data = (const unsigned char*)buffer.data() + 16 * entry;
+    std::string chunk_id((const char*)data, 4);
+    uint32_t flags = data[4] | data[5] << 8 | data[6] << 16 | (uint32_t)data[7] << 24;
+    uint32_t offset = data[8] | data[9] << 8 | data[10] << 16 | (uint32_t)data[11] << 24;
+    uint32_t chunk_size = data[12] | data[13] << 8 | data[14] << 16 | (uint32_t)data[15] << 24;
+    if (!isVideoChunk(chunk_id, stream_number))
+    {
+      continue;
+    }
+    if (nb_frames == 0)
+    {
+      relative_offsets = offset < movi_offset;
+    }
+    if (flags & AVIIF_KEYFRAME)
+    {
+      uint64_t absolute_offset = relative_offsets ? movi_offset + offset : offset;
+      keyframes.push_back({ nb_frames, absolute_offset, chunk_size });
+    }
+    nb_frames++;
+  }
+}
+
+}  // namespace hl_monitoring
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <json/json.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace hl_monitoring
+{
+/**
+ * Position of the keyframes in a video file, allows to seek directly to the start of a group of pictures (GOP).
+ *
+ * The index is extracted from the indices of AVI files (legacy 'idx1' chunk or OpenDML standard indices), it can be
+ * saved to avoid parsing the video again.
+ */
+class KeyframeIndex
+{
+public:
+  struct Keyframe
+  {
+    /**
+     * Index of the frame in the video stream
+     */
+    int frame_index;
+
+    /**
+     * Position of the chunk containing the frame in the video file [bytes]
+     */
+    uint64_t offset;
+
+    /**
+     * Size of the frame data [bytes]
+     */
+    uint32_t size;
+  };
+
+  KeyframeIndex();
+
+  /**
+   * Extract the keyframes of the first video stream of an AVI file. Returns false if the file is not an AVI file or
+   * if it does not contain any index, in this case the index is empty.
+   */
+  bool buildFromAvi(const std::string& video_path);
+
+  /**
+   * Load the index from the given path if it exists and matches the video file, otherwise build it from the video
+   * and try to save it at the given path. Returns true if the index is not empty.
+   */
+  bool loadOrBuild(const std::string& video_path, const std::string& index_path);
+
+  void clear();
+
+  bool empty() const;
+
+  /**
+   * Number of frames in the video stream
+   */
+  int getNbFrames() const;
+
+  const std::vector<Keyframe>& getKeyframes() const;
+
+  /**
+   * Return the index of the last keyframe before or at the given frame, 0 if there is no such keyframe
+   */
+  int getKeyframeBefore(int frame_index) const;
+
+  Json::Value toJson() const;
+  void fromJson(const Json::Value& v);
+
+private:
+  /**
+   * Parse the 'hdrl' list of an AVI file to find the number of the first video stream and the position of its
+   * OpenDML standard indices. stream_number is set to -1 if no video stream is found.
+   */
+  static void parseHeaderList(std::istream& in, uint64_t start, uint64_t end, int* stream_number,
+                              std::vector<uint64_t>* standard_indices);
+
+  /**
+   * Read the keyframes from an OpenDML standard index chunk ('ix##') starting at 'offset'
+   */
+  void parseStandardIndex(std::istream& in, uint64_t offset);
+
+  /**
+   * Read the keyframes from a legacy 'idx1' chunk
+   */
+  void parseLegacyIndex(std::istream& in, uint64_t start, uint32_t size, uint64_t movi_offset, int stream_number);
+
+  std::vector<Keyframe> keyframes;
+
+  int nb_frames;
+
+  /**
+   * Size of the video file used to build the index [bytes], allows to detect outdated indices
+   */
+  uint64_t video_size;
+};
+
+}  // namespace hl_monitoring
@@ -0,0 +1,472 @@
+#include "hl_monitoring/libav_replay_image_provider.h"
+#include "hl_monitoring/image_provider_factory.h"
+#include "hl_monitoring/meta_information_log.h"
+
+#include <hl_communication/utils.h>
+#include <hl_monitoring/profiler.h>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libswscale/swscale.h>
+}
+
+#include <cmath>
+
+using namespace hl_communication;
+
+namespace hl_monitoring
+{
+static std::unique_ptr<ImageProvider> buildLibavReplayImageProvider(const Json::Value& v,
+                                                                    const ImageProviderFactory::BuildContext& context)
+{
+  std::string input_path;
+  checkMember(v, "input_path");
+  readVal(v, "input_path", &input_path);
+  std::unique_ptr<LibavReplayImageProvider> provider;
+  if (v.isMember("meta_information_path"))
+  {
+    provider.reset(new LibavReplayImageProvider(input_path, v["meta_information_path"].asString()));
+  }
+  else
+  {
+    provider.reset(new LibavReplayImageProvider(input_path));
+  }
+  if (v.isMember("decoding_threads"))
+  {
+    int decoding_threads;
+    readVal(v, "decoding_threads", &decoding_threads);
+    provider->setNbDecodingThreads(decoding_threads);
+  }
+  if (v.isMember("pixel_format"))
+  {
+    std::string pixel_format;
+    readVal(v, "pixel_format", &pixel_format);
+    provider->setPixelFormat(LibavReplayImageProvider::string2PixelFormat(pixel_format));
+  }
+  int buffer_pool_size = 0;
+  tryReadVal(v, "buffer_pool_size", &buffer_pool_size);
+  if (buffer_pool_size > 0)
+  {
+    provider->setBufferPool(std::make_shared<ImageBufferPool>(buffer_pool_size));
+  }
+  return provider;
+}
+
+static ImageProviderFactory::Registrar registrar("LibavReplayImageProvider", buildLibavReplayImageProvider,
+                                                 ImageProviderFactory::Capabilities(false, true, false));
+
+/**
+ * Skipping up to this number of frames by decoding them is considered cheaper than seeking in the video
+ */
+static const int max_frames_skipped = 8;
+
+/**
+ * Return the description of a libav error code
+ */
+static std::string getErrorMessage(int error)
+{
+  char buffer[AV_ERROR_MAX_STRING_SIZE];
+  av_strerror(error, buffer, sizeof(buffer));
+  return buffer;
+}
+
+LibavReplayImageProvider::LibavReplayImageProvider(const std::string& video_path_)
+  : video_path(video_path_)
+  , format_context(nullptr)
+  , codec_context(nullptr)
+  , frame(nullptr)
+  , packet(nullptr)
+  , sws_context(nullptr)
+  , stream_index(-1)
+  , frame_duration(1)
+  , start_pts(0)
+  , decoder_index(-1)
+  , flushing(false)
+  , nb_decoding_threads(0)
+  , pixel_format(PixelFormat::BGR)
+{
+  openVideo(video_path);
+  setDefaultMetaInformation();
+}
+
+LibavReplayImageProvider::LibavReplayImageProvider(const std::string& video_path_,
+                                                   const std::string& meta_information_path)
+  : LibavReplayImageProvider(video_path_)
+{
+  loadMetaInformation(meta_information_path);
+}
+
+LibavReplayImageProvider::~LibavReplayImageProvider()
+{
+  close();
+}
+
+void LibavReplayImageProvider::openVideo(const std::string& path)
+{
+  int error = avformat_open_input(&format_context, path.c_str(), nullptr, nullptr);
+  if (error < 0)
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to open video '" + path + "': " + getErrorMessage(error));
+  }
+  error = avformat_find_stream_info(format_context, nullptr);
+  if (error < 0)
+  {
+    close();
+    throw std::runtime_error(HL_DEBUG + "Failed to read streams of '" + path + "': " + getErrorMessage(error));
+  }
+  stream_index = av_find_best_stream(format_context, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+  if (stream_index < 0)
+  {
+    close();
+    throw std::runtime_error(HL_DEBUG + "No video stream in '" + path + "'");
+  }
+  AVStream* stream = format_context->streams[stream_index];
+  AVRational frame_rate = stream->avg_frame_rate;
+  if (frame_rate.num == 0 || frame_rate.den == 0)
+  {
+    frame_rate = stream->r_frame_rate;
+  }
+  if (frame_rate.num == 0 || frame_rate.den == 0)
+  {
+    close();
+    throw std::runtime_error(HL_DEBUG + "Unknown frame rate for '" + path + "'");
+  }
+  frame_duration = 1.0 / (av_q2d(frame_rate) * av_q2d(stream->time_base));
+  start_pts = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+  if (stream->nb_frames > 0)
+  {
+    nb_frames = stream->nb_frames;
+  }
+  else if (stream->duration != AV_NOPTS_VALUE)
+  {
+    nb_frames = std::round(stream->duration / frame_duration);
+  }
+  else
+  {
+    nb_frames = std::round(format_context->duration * av_q2d(frame_rate) / AV_TIME_BASE);
+  }
+  frame = av_frame_alloc();
+  packet = av_packet_alloc();
+  try
+  {
+    openDecoder();
+  }
+  catch (const std::exception&)
+  {
+    // Called from the constructor: the destructor would not release the contexts
+    close();
+    throw;
+  }
+  index = 0;
+}
+
+void LibavReplayImageProvider::openDecoder()
+{
+  if (codec_context != nullptr)
+  {
+    avcodec_free_context(&codec_context);
+  }
+  const AVCodecParameters* parameters = format_context->streams[stream_index]->codecpar;
+  const AVCodec* codec = avcodec_find_decoder(parameters->codec_id);
+  if (codec == nullptr)
+  {
+    throw std::runtime_error(HL_DEBUG + "No decoder available for '" + video_path + "'");
+  }
+  codec_context = avcodec_alloc_context3(codec);
+  int error = avcodec_parameters_to_context(codec_context, parameters);
+  if (error < 0)
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to configure decoder: " + getErrorMessage(error));
+  }
+  codec_context->thread_count = nb_decoding_threads;
+  codec_context->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+  error = avcodec_open2(codec_context, codec, nullptr);
+  if (error < 0)
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to open decoder: " + getErrorMessage(error));
+  }
+  // Decoding restarts from the beginning of the file
+  av_seek_frame(format_context, stream_index, start_pts, AVSEEK_FLAG_BACKWARD);
+  decoder_index = -1;
+  flushing = false;
+}
+
+void LibavReplayImageProvider::close()
+{
+  sws_freeContext(sws_context);
+  sws_context = nullptr;
+  av_packet_free(&packet);
+  av_frame_free(&frame);
+  avcodec_free_context(&codec_context);
+  avformat_close_input(&format_context);
+}
+
+void LibavReplayImageProvider::setDefaultMetaInformation()
+{
+  uint64_t dt = std::round(frame_duration * av_q2d(format_context->streams[stream_index]->time_base) * 1000 * 1000);
+  uint64_t monotonic_ts = 0;
+  uint64_t utc_ts = getUTCTimeStamp();  // When setting default meta-information, use current date
+  time_stamp_index.reserve(nb_frames);
+  for (int idx = 0; idx < nb_frames; idx++)
+  {
+    FrameEntry* entry = meta_information.add_frames();
+    entry->set_monotonic_ts(monotonic_ts);
+    entry->set_utc_ts(utc_ts);
+    pushTimeStamp(idx, monotonic_ts);
+    monotonic_ts += dt;
+    utc_ts += dt;
+  }
+}
+
+void LibavReplayImageProvider::loadMetaInformation(const std::string& meta_information_path)
+{
+  meta_information.Clear();
+  readMetaInformation(meta_information_path, &meta_information);
+  invalidateCameraMetaInformation();
+  index = 0;
+  nb_frames = meta_information.frames_size();
+  time_stamp_index.clear();
+  time_stamp_index.reserve(nb_frames);
+  for (int idx = 0; idx < nb_frames; idx++)
+  {
+    uint64_t time_stamp = getTS(meta_information.frames(idx), true);
+    if (time_stamp_index.hasTimeStamp(time_stamp))
+    {
+      throw std::runtime_error(HL_DEBUG + "Duplicated time_stamp " + std::to_string(time_stamp));
+    }
+    pushTimeStamp(idx, time_stamp);
+  }
+}
+
+void LibavReplayImageProvider::restartStream()
+{
+  setIndex(0);
+}
+
+CalibratedImage LibavReplayImageProvider::getCalibratedImage(uint64_t time_stamp)
+{
+  int new_index = getIndex(time_stamp);
+  cv::Mat img;
+  if (new_index == -1)
+  {
+    return CalibratedImage();
+  }
+  else if (new_index == index - 1 && !last_img.empty())  // Asking for previous image again
+  {
+    img = last_img;
+  }
+  else
+  {
+    std::lock_guard<std::mutex> lock(video_mutex);
+    img = decodeFrame(new_index);
+    last_img = img;
+    index = new_index + 1;
+  }
+  return CalibratedImage(img, getSharedCameraMetaInformation(new_index));
+}
+
+cv::Mat LibavReplayImageProvider::getNextImg()
+{
+  if (isStreamFinished())
+  {
+    throw std::logic_error("Asking for a new frame while stream is finished");
+  }
+  std::lock_guard<std::mutex> lock(video_mutex);
+  last_img = decodeFrame(index);
+  index++;
+  return last_img;
+}
+
+void LibavReplayImageProvider::update()
+{
+  // Nothing required
+}
+
+bool LibavReplayImageProvider::isStreamFinished()
+{
+  return index >= nb_frames;
+}
+
+void LibavReplayImageProvider::setIndex(int new_index)
+{
+  if (new_index < 0 || new_index > nb_frames)
+  {
+    throw std::out_of_range(HL_DEBUG + "Failed to set index to " + std::to_string(new_index) + " in video");
+  }
+  // Seeking in the video is only done when the frame is actually required
+  index = new_index;
+}
+
+void LibavReplayImageProvider::setNbDecodingThreads(int nb_threads)
+{
+  if (nb_threads < 0)
+  {
+    throw std::out_of_range(HL_DEBUG + " invalid number of threads: " + std::to_string(nb_threads));
+  }
+  std::lock_guard<std::mutex> lock(video_mutex);
+  nb_decoding_threads = nb_threads;
+  openDecoder();
+}
+
+void LibavReplayImageProvider::setPixelFormat(PixelFormat format)
+{
+  std::lock_guard<std::mutex> lock(video_mutex);
+  pixel_format = format;
+  last_img = cv::Mat();
+}
+
+void LibavReplayImageProvider::setBufferPool(std::shared_ptr<ImageBufferPool> pool)
+{
+  std::lock_guard<std::mutex> lock(video_mutex);
+  buffer_pool = std::move(pool);
+}
+
+LibavReplayImageProvider::PixelFormat LibavReplayImageProvider::string2PixelFormat(const std::string& str)
+{
+  if (str == "bgr")
+  {
+    return PixelFormat::BGR;
+  }
+  if (str == "gray")
+  {
+    return PixelFormat::Gray;
+  }
+  throw std::out_of_range(HL_DEBUG + " cannot convert str '" + str + "' to pixel format");
+}
+
+cv::Mat LibavReplayImageProvider::decodeFrame(int frame_index)
+{
+  ScopedTimer timer("LibavReplayImageProvider::decodeFrame");
+  if (frame_index < 0 || frame_index >= nb_frames)
+  {
+    throw std::out_of_range(HL_DEBUG + "invalid frame index: " + std::to_string(frame_index) + "/" +
+                            std::to_string(nb_frames));
+  }
+  if (frame_index == decoder_index)
+  {
+    return convertFrame();
+  }
+  bool sequential = decoder_index >= 0 && frame_index > decoder_index &&
+                    frame_index <= decoder_index + max_frames_skipped;
+  if (!sequential)
+  {
+    seek(frame_index);
+  }
+  bool restarted = false;
+  while (true)
+  {
+    if (!decodeNextFrame())
+    {
+      throw std::runtime_error(HL_DEBUG + "End of stream reached before frame " + std::to_string(frame_index) + "/" +
+                               std::to_string(nb_frames));
+    }
+    if (decoder_index == frame_index)
+    {
+      return convertFrame();
+    }
+    if (decoder_index > frame_index)
+    {
+      if (restarted)
+      {
+        throw std::runtime_error(HL_DEBUG + "Frame " + std::to_string(frame_index) + " not found in stream");
+      }
+      // The demuxer placed us after the requested frame: decode from the beginning instead
+      seek(0);
+      restarted = true;
+    }
+  }
+}
+
+void LibavReplayImageProvider::seek(int frame_index)
+{
+  int error = av_seek_frame(format_context, stream_index, getPTS(frame_index), AVSEEK_FLAG_BACKWARD);
+  if (error < 0)
+  {
+    decoder_index = -1;
+    throw std::runtime_error(HL_DEBUG + "Failed to seek to frame " + std::to_string(frame_index) + ": " +
+                             getErrorMessage(error));
+  }
+  avcodec_flush_buffers(codec_context);
+  decoder_index = -1;
+  flushing = false;
+}
+
+bool LibavReplayImageProvider::decodeNextFrame()
+{
+  while (true)
+  {
+    int error = avcodec_receive_frame(codec_context, frame);
+    if (error == 0)
+    {
+      int64_t pts = frame->best_effort_timestamp;
+      // Without time stamp, frames are assumed to follow each other
+      decoder_index = pts == AV_NOPTS_VALUE ? decoder_index + 1 : getFrameIndex(pts);
+      return true;
+    }
+    if (error == AVERROR_EOF)
+    {
+      return false;
+    }
+    if (error != AVERROR(EAGAIN))
+    {
+      throw std::runtime_error(HL_DEBUG + "Failed to decode frame: " + getErrorMessage(error));
+    }
+    if (flushing)
+    {
+      return false;
+    }
+    // Decoder needs more data
+    error = av_read_frame(format_context, packet);
+    if (error == AVERROR_EOF)
+    {
+      // Frames still buffered by the decoder are retrieved by sending an empty packet
+      flushing = true;
+      avcodec_send_packet(codec_context, nullptr);
+      continue;
+    }
+    if (error < 0)
+    {
+      throw std::runtime_error(HL_DEBUG + "Failed to read packet: " + getErrorMessage(error));
+    }
+    if (packet->stream_index == stream_index)
+    {
+      error = avcodec_send_packet(codec_context, packet);
+    }
+    av_packet_unref(packet);
+    if (error < 0)
+    {
+      throw std::runtime_error(HL_DEBUG + "Failed to send packet to decoder: " + getErrorMessage(error));
+    }
+  }
+}
+
+cv::Mat LibavReplayImageProvider::convertFrame()
+{
+  AVPixelFormat dst_format = pixel_format == PixelFormat::Gray ? AV_PIX_FMT_GRAY8 : AV_PIX_FMT_BGR24;
+  int type = pixel_format == PixelFormat::Gray ? CV_8UC1 : CV_8UC3;
+  sws_context = sws_getCachedContext(sws_context, frame->width, frame->height, (AVPixelFormat)frame->format,
+                                     frame->width, frame->height, dst_format, SWS_BILINEAR, nullptr, nullptr, nullptr);
+  if (sws_context == nullptr)
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to create conversion context");
+  }
+  cv::Size size(frame->width, frame->height);
+  cv::Mat img = buffer_pool ? buffer_pool->acquire(size, type) : cv::Mat(size, type);
+  uint8_t* dst_data[1] = { img.data };
+  int dst_linesize[1] = { (int)img.step[0] };
+  sws_scale(sws_context, frame->data, frame->linesize, 0, frame->height, dst_data, dst_linesize);
+  return img;
+}
+
+int LibavReplayImageProvider::getFrameIndex(int64_t pts) const
+{
+  return std::round((pts - start_pts) / frame_duration);
+}
+
+int64_t LibavReplayImageProvider::getPTS(int frame_index) const
+{
+  return start_pts + std::llround(frame_index * frame_duration);
+}
+
+}  // namespace hl_monitoring
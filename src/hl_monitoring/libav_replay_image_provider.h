@@ -0,0 +1,165 @@
+#pragma once
+
+#include "hl_monitoring/image_buffer_pool.h"
+#include "hl_monitoring/image_provider.h"
+
+#include <memory>
+#include <mutex>
+
+struct AVCodecContext;
+struct AVFormatContext;
+struct AVFrame;
+struct AVPacket;
+struct SwsContext;
+
+namespace hl_monitoring
+{
+/**
+ * Provides images from a video file decoded directly with libavformat and libavcodec.
+ *
+ * Compared to ReplayImageProvider:
+ * - Decoding uses several threads (frame and slice threading, depending on the codec)
+ * - Seeking is based on the presentation time stamps of the packets: the decoder jumps to the keyframe before the
+ *   requested frame and frames are discarded until the presentation time stamp of the requested frame is reached
+ * - Images can be converted to BGR or to grayscale
+ * - Images can be written in the buffers of a shared ImageBufferPool instead of being allocated for each frame
+ *
+ * Frame i of the video is described by the entry i of the meta information, presentation time stamps are converted
+ * to frame indices using the frame rate of the video stream.
+ */
+class LibavReplayImageProvider : public ImageProvider
+{
+public:
+  /**
+   * Format of the images provided
+   */
+  enum class PixelFormat
+  {
+    BGR,
+    Gray
+  };
+
+  LibavReplayImageProvider(const std::string& video_path);
+  LibavReplayImageProvider(const std::string& video_path, const std::string& meta_information_path);
+  virtual ~LibavReplayImageProvider();
+
+  void restartStream() override;
+
+  CalibratedImage getCalibratedImage(uint64_t time_stamp) override;
+
+  cv::Mat getNextImg() override;
+
+  void update() override;
+
+  bool isStreamFinished() override;
+
+  void setIndex(int index);
+
+  /**
+   * Number of threads used by the decoder, 0 lets libavcodec choose. Takes effect on the next opening of the decoder.
+   */
+  void setNbDecodingThreads(int nb_threads);
+
+  void setPixelFormat(PixelFormat format);
+
+  /**
+   * Images are written in the buffers of the pool, if null images are allocated for each frame
+   */
+  void setBufferPool(std::shared_ptr<ImageBufferPool> pool);
+
+  static PixelFormat string2PixelFormat(const std::string& str);
+
+private:
+  void openVideo(const std::string& video_path);
+
+  /**
+   * Open the decoder for the current video stream, closing the previous one if required
+   */
+  void openDecoder();
+  void close();
+
+  /**
+   * Creates default meta information based on the frame rate of the video stream
+   */
+  void setDefaultMetaInformation();
+
+  void loadMetaInformation(const std::string& meta_information_path);
+
+  /**
+   * Decode the image at the given index, seeking in the video only if required. video_mutex has to be locked.
+   */
+  cv::Mat decodeFrame(int frame_index);
+
+  /**
+   * Seek to the keyframe before the given frame and discard the frames decoded before
+   */
+  void seek(int frame_index);
+
+  /**
+   * Decode the next frame of the stream in 'frame' and update decoder_index, returns false at the end of the stream
+   */
+  bool decodeNextFrame();
+
+  /**
+   * Convert 'frame' to an image in the current pixel format
+   */
+  cv::Mat convertFrame();
+
+  /**
+   * Index of the frame with the given presentation time stamp
+   */
+  int getFrameIndex(int64_t pts) const;
+
+  /**
+   * Presentation time stamp of the frame with the given index
+   */
+  int64_t getPTS(int frame_index) const;
+
+  std::string video_path;
+
+  AVFormatContext* format_context;
+  AVCodecContext* codec_context;
+  AVFrame* frame;
+  AVPacket* packet;
+  SwsContext* sws_context;
+
+  /**
+   * Index of the video stream in the container
+   */
+  int stream_index;
+
+  /**
+   * Duration of a frame in the time base of the stream
+   */
+  double frame_duration;
+
+  /**
+   * Presentation time stamp of the first frame
+   */
+  int64_t start_pts;
+
+  /**
+   * Index of the frame currently in 'frame', -1 if there is none
+   */
+  int decoder_index;
+
+  /**
+   * Has the end of the stream been sent to the decoder
+   */
+  bool flushing;
+
+  int nb_decoding_threads;
+
+  PixelFormat pixel_format;
+
+  std::shared_ptr<ImageBufferPool> buffer_pool;
+
+  std::mutex video_mutex;
+
+  /**
+   * The last image retrieved
+   */
+  cv::Mat last_img;
+};
+
+}  // namespace hl_monitoring
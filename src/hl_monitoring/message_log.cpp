@@ -0,0 +1,158 @@
+#include "hl_monitoring/message_log.h"
+
+#include <hl_communication/utils.h>
+
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/util/delimited_message_util.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <iostream>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+using namespace hl_communication;
+
+namespace hl_monitoring
+{
+/**
+ * Starts with a null byte, like streamed meta information, so that segments can not be confused with protobuf files
+ */
+static const std::string magic("\0hlmsgs1", 8);
+
+MessageLogWriter::MessageLogWriter(uint64_t max_segment_size_)
+  : nb_segments(0), segment_size(0), max_segment_size(max_segment_size_)
+{
+}
+
+MessageLogWriter::~MessageLogWriter()
+{
+  close();
+}
+
+void MessageLogWriter::open(const std::string& new_directory)
+{
+  if (isOpened())
+  {
+    throw std::logic_error(HL_DEBUG + " message log is already opened");
+  }
+  if (mkdir(new_directory.c_str(), 0755) != 0 && errno != EEXIST)
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to create directory at '" + new_directory + "'");
+  }
+  directory = new_directory;
+  nb_segments = 0;
+}
+
+bool MessageLogWriter::isOpened() const
+{
+  return directory != "";
+}
+
+void MessageLogWriter::close()
+{
+  if (out.is_open())
+  {
+    out.close();
+  }
+  directory = "";
+}
+
+void MessageLogWriter::append(const MessageCollection& messages)
+{
+  if (!isOpened())
+  {
+    throw std::logic_error(HL_DEBUG + " message log is not opened");
+  }
+  if (messages.ByteSizeLong() == 0)
+  {
+    return;
+  }
+  if (!out.is_open() || segment_size >= max_segment_size)
+  {
+    openSegment();
+  }
+  std::streampos start = out.tellp();
+  if (!google::protobuf::util::SerializeDelimitedToOstream(messages, &out) || !out.flush())
+  {
+    // The record might be incomplete, following records are written in a new segment
+    out.close();
+    throw std::runtime_error(HL_DEBUG + "Failed to write messages to segment " + std::to_string(nb_segments - 1) +
+                             " of '" + directory + "'");
+  }
+  segment_size += out.tellp() - start;
+}
+
+int MessageLogWriter::getNbSegments() const
+{
+  return nb_segments;
+}
+
+void MessageLogWriter::openSegment()
+{
+  if (out.is_open())
+  {
+    out.close();
+  }
+  std::string path = getMessageSegmentPath(directory, nb_segments);
+  nb_segments++;
+  out.open(path, std::ios::binary | std::ios::trunc);
+  if (!out.good())
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to open file '" + path + "'");
+  }
+  out.write(magic.data(), magic.size());
+  out.flush();
+  segment_size = magic.size();
+}
+
+std::string getMessageSegmentPath(const std::string& directory, int segment_index)
+{
+  char name[32];
+  snprintf(name, sizeof(name), "segment_%06d.bin", segment_index);
+  return directory + "/" + name;
+}
+
+void readMessageLog(const std::string& directory, MessageCollection* messages)
+{
+  messages->Clear();
+  for (int segment_index = 0;; segment_index++)
+  {
+    std::string path = getMessageSegmentPath(directory, segment_index);
+    std::ifstream in(path, std::ios::binary);
+    if (!in.good())
+    {
+      if (segment_index == 0)
+      {
+        throw std::runtime_error(HL_DEBUG + "No message segment found in '" + directory + "'");
+      }
+      return;
+    }
+    std::string prefix(magic.size(), '\0');
+    in.read(&(prefix[0]), prefix.size());
+    if (!in.good() || prefix != magic)
+    {
+      std::cerr << HL_DEBUG << "Ignoring invalid segment '" << path << "'" << std::endl;
+      continue;
+    }
+    google::protobuf::io::IstreamInputStream input(&in);
+    while (true)
+    {
+      MessageCollection record;
+      bool clean_eof = false;
+      if (!google::protobuf::util::ParseDelimitedFromZeroCopyStream(&record, &input, &clean_eof))
+      {
+        if (!clean_eof)
+        {
+          std::cerr << HL_DEBUG << "Ignoring incomplete record at the end of '" << path << "'" << std::endl;
+        }
+        break;
+      }
+      // Repeated fields are appended, messages stay ordered by reception
+      messages->MergeFrom(record);
+    }
+  }
+}
+
+}  // namespace hl_monitoring
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <hl_communication/wrapper.pb.h>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+namespace hl_monitoring
+{
+/**
+ * Append-only log of the messages received during a live session, split in segments of bounded size so that no file
+ * has to be rewritten while the session goes on.
+ *
+ * Each segment starts with a magic sequence followed by length-delimited MessageCollection records, one record per
+ * call to append. Segments are flushed after each record: if the program stops unexpectedly, only the last record of a
+ * segment might be incomplete and it is ignored on reading.
+ */
+class MessageLogWriter
+{
+public:
+  /**
+   * max_segment_size: a new segment is started once the current one exceeds this size [bytes]
+   */
+  MessageLogWriter(uint64_t max_segment_size = 16 * 1024 * 1024);
+  ~MessageLogWriter();
+
+  MessageLogWriter(const MessageLogWriter& other) = delete;
+  MessageLogWriter& operator=(const MessageLogWriter& other) = delete;
+
+  /**
+   * Create the directory containing the segments, throws a runtime_error on failure. Segments are created when
+   * messages are appended.
+   */
+  void open(const std::string& directory);
+
+  bool isOpened() const;
+
+  void close();
+
+  /**
+   * Append the messages to the current segment, empty collections are ignored. Throws a runtime_error on failure, the
+   * segment is then closed and the next messages are written in a new segment.
+   */
+  void append(const hl_communication::MessageCollection& messages);
+
+  int getNbSegments() const;
+
+private:
+  void openSegment();
+
+  std::string directory;
+
+  std::ofstream out;
+
+  int nb_segments;
+
+  /**
+   * Number of bytes written in the current segment
+   */
+  uint64_t segment_size;
+
+  uint64_t max_segment_size;
+};
+
+/**
+ * Return the path of the segment with the given index in a message log
+ */
+std::string getMessageSegmentPath(const std::string& directory, int segment_index);
+
+/**
+ * Read all the segments of a message log in order. Incomplete or invalid records end the reading of their segment, a
+ * warning is printed and the next segment is read.
+ */
+void readMessageLog(const std::string& directory, hl_communication::MessageCollection* messages);
+
+}  // namespace hl_monitoring
@@ -0,0 +1,216 @@
+#include "hl_monitoring/meta_information_log.h"
+
+#include <hl_communication/utils.h>
+
+#include <google/protobuf/io/zero_copy_stream_impl.h>
+#include <google/protobuf/util/delimited_message_util.h>
+
+#include <iostream>
+#include <map>
+
+using namespace hl_communication;
+
+namespace hl_monitoring
+{
+/**
+ * Starts with a null byte, which is not a valid protobuf tag, therefore legacy files can not start with it
+ */
+static const std::string magic("\0hlmeta2", 8);
+
+/**
+ * Files written before record types were introduced, each record is directly a VideoMetaInformation
+ */
+static const std::string magic_v1("\0hlmeta1", 8);
+
+static const char frames_record = 'F';
+static const char header_record = 'H';
+static const char frame_update_record = 'U';
+
+MetaInformationWriter::MetaInformationWriter()
+{
+}
+
+MetaInformationWriter::~MetaInformationWriter()
+{
+  close();
+}
+
+void MetaInformationWriter::open(const std::string& new_path)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (out.is_open())
+  {
+    throw std::logic_error(HL_DEBUG + " meta information writer is already opened");
+  }
+  out.open(new_path, std::ios::binary | std::ios::trunc);
+  if (!out.good())
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to open file '" + new_path + "'");
+  }
+  path = new_path;
+  out.write(magic.data(), magic.size());
+  out.flush();
+}
+
+bool MetaInformationWriter::isOpened() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return out.is_open();
+}
+
+void MetaInformationWriter::close()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (out.is_open())
+  {
+    out.close();
+  }
+}
+
+void MetaInformationWriter::writeHeader(const VideoMetaInformation& header)
+{
+  if (header.frames_size() > 0)
+  {
+    throw std::logic_error(HL_DEBUG + " header should not contain frames");
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  writeRecord(header_record, header);
+}
+
+void MetaInformationWriter::writeFrame(const FrameEntry& frame)
+{
+  VideoMetaInformation record;
+  record.add_frames()->CopyFrom(frame);
+  std::lock_guard<std::mutex> lock(mutex);
+  writeRecord(frames_record, record);
+}
+
+void MetaInformationWriter::writeFrameUpdate(const FrameEntry& frame)
+{
+  VideoMetaInformation record;
+  record.add_frames()->CopyFrom(frame);
+  std::lock_guard<std::mutex> lock(mutex);
+  writeRecord(frame_update_record, record);
+}
+
+void MetaInformationWriter::writeRecord(char record_type, const VideoMetaInformation& record)
+{
+  if (!out.is_open())
+  {
+    throw std::logic_error(HL_DEBUG + " meta information writer is not opened");
+  }
+  out.put(record_type);
+  if (!google::protobuf::util::SerializeDelimitedToOstream(record, &out))
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to write to file '" + path + "'");
+  }
+  out.flush();
+}
+
+void readMetaInformation(const std::string& path, VideoMetaInformation* information)
+{
+  std::ifstream in(path, std::ios::binary);
+  if (!in.good())
+  {
+    throw std::runtime_error(HL_DEBUG + "Failed to open file '" + path + "'");
+  }
+  information->Clear();
+  std::string prefix(magic.size(), '\0');
+  in.read(&(prefix[0]), prefix.size());
+  bool typed_records = prefix == magic;
+  if (!in.good() || (!typed_records && prefix != magic_v1))
+  {
+    in.clear();
+    in.seekg(0);
+    if (!information->ParseFromIstream(&in))
+    {
+      throw std::runtime_error(HL_DEBUG + "Failed to read file '" + path + "'");
+    }
+    return;
+  }
+  google::protobuf::io::IstreamInputStream input(&in);
+  // Updates are applied once all the frames are read, since they might be written before the frame itself
+  std::map<uint64_t, FrameEntry> frame_updates;
+  while (true)
+  {
+    char record_type = frames_record;
+    if (typed_records)
+    {
+      const void* data;
+      int size = 0;
+      while (size == 0)
+      {
+        if (!input.Next(&data, &size))
+        {
+          break;
+        }
+      }
+      if (size == 0)
+      {
+        // Clean end of file
+        break;
+      }
+      record_type = *(const char*)data;
+      input.BackUp(size - 1);
+    }
+    VideoMetaInformation record;
+    bool clean_eof = false;
+    if (!google::protobuf::util::ParseDelimitedFromZeroCopyStream(&record, &input, &clean_eof))
+    {
+      if (!clean_eof || typed_records)
+      {
+        std::cerr << HL_DEBUG << "Ignoring incomplete record at the end of '" << path << "'" << std::endl;
+      }
+      break;
+    }
+    if (record_type == frame_update_record)
+    {
+      for (const FrameEntry& frame : record.frames())
+      {
+        frame_updates[frame.monotonic_ts()] = frame;
+      }
+      continue;
+    }
+    if (record_type != frames_record && record_type != header_record)
+    {
+      std::cerr << HL_DEBUG << "Ignoring records after unknown record type in '" << path << "'" << std::endl;
+      break;
+    }
+    for (const FrameEntry& frame : record.frames())
+    {
+      information->add_frames()->CopyFrom(frame);
+    }
+    record.clear_frames();
+    // Without record types, records containing only frames do not modify the header
+    if (record_type == header_record || (!typed_records && record.ByteSizeLong() > 0))
+    {
+      // Frames are kept aside while the header is replaced
+      google::protobuf::RepeatedPtrField<FrameEntry> frames;
+      frames.Swap(information->mutable_frames());
+      information->CopyFrom(record);
+      information->mutable_frames()->Swap(&frames);
+    }
+  }
+  if (frame_updates.size() > 0)
+  {
+    for (FrameEntry& frame : *(information->mutable_frames()))
+    {
+      auto it = frame_updates.find(frame.monotonic_ts());
+      if (it != frame_updates.end())
+      {
+        frame.CopyFrom(it->second);
+      }
+    }
+  }
+}
+
+VideoMetaInformation extractHeader(VideoMetaInformation* information)
+{
+  google::protobuf::RepeatedPtrField<FrameEntry> frames;
+  frames.Swap(information->mutable_frames());
+  VideoMetaInformation header(*information);
+  information->mutable_frames()->Swap(&frames);
+  return header;
+}
+
+}  // namespace hl_monitoring
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <hl_communication/camera.pb.h>
+
+#include <fstream>
+#include <mutex>
+#include <string>
+
+namespace hl_monitoring
+{
+/**
+ * Writes the meta information of a video incrementally, so that memory usage does not depend on the length of the
+ * recording and that frames already written are not lost if the program stops unexpectedly.
+ *
+ * The file starts with a magic sequence followed by records, each record is a byte describing its type followed by a
+ * length-delimited VideoMetaInformation. A record contains either:
+ * - Frames, which are appended to the frames already read
+ * - The information shared by all the frames, which replaces the previous one
+ * - Updated frames, which replace the frames with the same monotonic time stamp, wherever they appear in the file
+ *
+ * Files written by the first version of the writer, without record types, can still be read.
+ */
+class MetaInformationWriter
+{
+public:
+  MetaInformationWriter();
+  ~MetaInformationWriter();
+
+  MetaInformationWriter(const MetaInformationWriter& other) = delete;
+  MetaInformationWriter& operator=(const MetaInformationWriter& other) = delete;
+
+  /**
+   * Create the file and write the magic sequence, throws a runtime_error on failure
+   */
+  void open(const std::string& path);
+
+  bool isOpened() const;
+
+  void close();
+
+  /**
+   * Write the information shared by all the frames, 'header' is expected not to contain any frame
+   */
+  void writeHeader(const hl_communication::VideoMetaInformation& header);
+
+  void writeFrame(const hl_communication::FrameEntry& frame);
+
+  /**
+   * Write a new version of a frame already written or about to be written, e.g. after its pose has been modified. The
+   * update is ignored on reading if no frame has the same monotonic time stamp.
+   */
+  void writeFrameUpdate(const hl_communication::FrameEntry& frame);
+
+private:
+  /**
+   * Append the record and flush the file, mutex has to be locked
+   */
+  void writeRecord(char record_type, const hl_communication::VideoMetaInformation& record);
+
+  /**
+   * Frames are usually written from an encoding thread while the header is written by the provider
+   */
+  mutable std::mutex mutex;
+
+  std::ofstream out;
+
+  std::string path;
+};
+
+/**
+ * Read meta information written either as a single message (legacy format) or by a MetaInformationWriter. If the last
+ * record of a streamed file is incomplete, it is ignored and a warning is printed.
+ */
+void readMetaInformation(const std::string& path, hl_communication::VideoMetaInformation* information);
+
+/**
+ * Return a copy of the information without its frames, the cost does not depend on the number of frames
+ */
+hl_communication::VideoMetaInformation extractHeader(hl_communication::VideoMetaInformation* information);
+
+}  // namespace hl_monitoring
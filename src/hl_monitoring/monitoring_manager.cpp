@@ -2,31 +2,62 @@
 
 #include <hl_communication/utils.h>
 #include <hl_communication/game_controller_utils.h>
-#include <hl_monitoring/opencv_image_provider.h>
-#include <hl_monitoring/replay_image_provider.h>
+#include <hl_monitoring/jpeg_chunk_log.h>
+#include <hl_monitoring/profiler.h>
 
+#include <algorithm>
 #include <fstream>
+#include <iostream>
 
 #include <sys/stat.h>
 #include <sys/types.h>
 
-#ifdef HL_MONITORING_USES_FLYCAPTURE
-#include <hl_monitoring/flycap_image_provider.h>
-#endif
-
 using namespace hl_communication;
 
 namespace hl_monitoring
 {
-MonitoringManager::MonitoringManager() : live(false)
+/**
+ * Above this progression of the time between two calls to getSynchronizedImages, it is considered as a jump in the
+ * replay and no frame is requested in advance [us]
+ */
+static const uint64_t max_playback_step = 1000 * 1000;
+
+/**
+ * Frames are discarded once the history exceeds the retention window by this ratio, so that discarding happens by
+ * batches instead of on every update
+ */
+static const double retention_margin = 1.25;
+
+MonitoringManager::StreamPlayback::StreamPlayback() : pending_index(-1), delivered_index(-1)
+{
+}
+
+MonitoringManager::MonitoringManager()
+  : live(false)
+  , nb_threads(0)
+  , max_latency(0)
+  , last_playback_time(0)
+  , retention_window(0)
+  , messages_save_period(10.0)
+  , persistence_stop(false)
 {
 }
 
 MonitoringManager::~MonitoringManager()
 {
-  if (output_prefix != "")
+  // Pending tasks are executed before the workers are joined
+  thread_pool.reset();
+  stopMessagesPersistence();
+  if (live && output_prefix != "")
   {
-    message_manager->saveMessages(output_prefix + "messages.bin");
+    try
+    {
+      saveMessages();
+    }
+    catch (const std::exception& exc)
+    {
+      std::cerr << HL_DEBUG << "Failed to save messages: " << exc.what() << std::endl;
+    }
   }
   for (auto& entry : image_providers)
   {
@@ -38,11 +69,13 @@ void MonitoringManager::autoLiveStart()
 {
   live = true;
   image_providers.clear();
+  providers_capabilities.clear();
   message_manager.reset(new MessageManager(getGCDefaultPort(), true));
   field = Field();
   team_manager = TeamManager();
   setupOutput();
   dumpReplayConfig();
+  startMessagesPersistence();
 }
 
 void MonitoringManager::loadConfig(const std::string& path)
@@ -52,6 +85,21 @@ void MonitoringManager::loadConfig(const std::string& path)
   // Parsing json content
   readVal(root, "live", &live);
   tryReadVal(root, "output_prefix", &output_prefix);
+  int new_nb_threads = nb_threads;
+  tryReadVal(root, "nb_threads", &new_nb_threads);
+  setNbThreads(new_nb_threads);
+  double playback_speed = playback_clock.getSpeed();
+  tryReadVal(root, "playback_speed", &playback_speed);
+  playback_clock.setSpeed(playback_speed);
+  double max_latency_ms = max_latency / 1000.0;
+  tryReadVal(root, "max_latency_ms", &max_latency_ms);
+  setMaxLatency(max_latency_ms * 1000);
+  double new_retention_window = retention_window;
+  tryReadVal(root, "retention_window", &new_retention_window);
+  setRetentionWindow(new_retention_window);
+  double save_period = messages_save_period;
+  tryReadVal(root, "messages_save_period", &save_period);
+  setMessagesSavePeriod(save_period);
   setupOutput();
   checkMember(root, "image_providers");
   checkMember(root, "message_manager");
@@ -62,6 +110,7 @@ void MonitoringManager::loadConfig(const std::string& path)
   loadImageProviders(root["image_providers"]);
   loadMessageManager(root["message_manager"]);
   dumpReplayConfig();
+  startMessagesPersistence();
 }
 
 void MonitoringManager::setupOutput()
@@ -93,11 +142,20 @@ void MonitoringManager::dumpReplayConfig()
   v["image_providers"] = Json::Value(Json::ValueType::objectValue);
   for (const auto& entry : image_providers)
   {
-    v["image_providers"][entry.first]["class_name"] = "ReplayImageProvider";
-    v["image_providers"][entry.first]["input_path"] = entry.first + ".avi";
+    // Videos are written in the output folder, paths of the replay config are relative to it
+    std::string video_path = entry.second->getOutputVideoPath();
+    std::string input_path = video_path.substr(video_path.find_last_of('/') + 1);
+    if (input_path == "")
+    {
+      input_path = entry.first + ".avi";
+    }
+    // Intra-only recordings have a dedicated provider allowing direct access to any frame
+    std::string class_name = isJpegChunkPath(input_path) ? "JpegChunkReplayImageProvider" : "ReplayImageProvider";
+    v["image_providers"][entry.first]["class_name"] = class_name;
+    v["image_providers"][entry.first]["input_path"] = input_path;
     v["image_providers"][entry.first]["meta_information_path"] = entry.first + ".bin";
   }
-  v["message_manager"]["file_path"] = "messages.bin";
+  v["message_manager"]["log_path"] = "messages";
   v["field"] = field.toJson();
   v["team_manager"] = team_manager.toJson();
   writeJson(v, output_prefix + "replay.json", true);
@@ -105,45 +163,15 @@ void MonitoringManager::dumpReplayConfig()
 
 std::unique_ptr<ImageProvider> MonitoringManager::buildImageProvider(const Json::Value& v, const std::string& name)
 {
-  checkMember(v, "class_name");
-  std::unique_ptr<ImageProvider> result;
-  std::string class_name, input_path, intrinsic_path, default_pose_path;
-  readVal(v, "class_name", &class_name);
+  std::string intrinsic_path, default_pose_path;
   tryReadVal(v, "intrinsic_path", &intrinsic_path);
   tryReadVal(v, "default_pose_path", &default_pose_path);
-  std::string image_provider_prefix = output_prefix + name;
-  if (class_name == "OpenCVImageProvider")
-  {
-    checkMember(v, "input_path");
-    readVal(v, "input_path", &input_path);
-    result.reset(new OpenCVImageProvider(input_path, image_provider_prefix));
-  }
-  else if (class_name == "ReplayImageProvider")
-  {
-    checkMember(v, "input_path");
-    readVal(v, "input_path", &input_path);
-    std::string meta_information_path;
-    if (v.isMember("meta_information_path"))
-    {
-      result.reset(new ReplayImageProvider(input_path, v["meta_information_path"].asString()));
-    }
-    else
-    {
-      result.reset(new ReplayImageProvider(input_path));
-    }
-  }
-#ifdef HL_MONITORING_USES_FLYCAPTURE
-  else if (class_name == "FlyCapImageProvider")
-  {
-    checkMember(v, "parameters");
-    const Json::Value& parameters = v["parameters"];
-    result.reset(new FlyCapImageProvider(parameters, image_provider_prefix));
-  }
-#endif
-  else
-  {
-    throw std::runtime_error(HL_DEBUG + "unknown class: '" + class_name + "'");
-  }
+  bool undistort = false;
+  tryReadVal(v, "undistort", &undistort);
+  ImageProviderFactory::BuildContext context;
+  context.output_prefix = output_prefix + name;
+  context.field = &field;
+  std::unique_ptr<ImageProvider> result = ImageProviderFactory::getDefault().build(v, context);
   if (intrinsic_path != "")
   {
     IntrinsicParameters intrinsic_params;
@@ -156,6 +184,7 @@ std::unique_ptr<ImageProvider> MonitoringManager::buildImageProvider(const Json:
     readFromFile(default_pose_path, &pose);
     result->setDefaultPose(pose);
   }
+  result->setUndistortion(undistort);
   return result;
 }
 
@@ -168,7 +197,9 @@ void MonitoringManager::loadImageProviders(const Json::Value& v)
   for (Json::ValueConstIterator it = v.begin(); it != v.end(); it++)
   {
     const std::string& key = it.name();
-    addImageProvider(key, buildImageProvider(v[key], key));
+    std::unique_ptr<ImageProvider> provider = buildImageProvider(v[key], key);
+    addImageProvider(key, std::move(provider),
+                     ImageProviderFactory::getDefault().getCapabilities(v[key]["class_name"].asString()));
   }
 }
 
@@ -178,9 +209,10 @@ void MonitoringManager::loadMessageManager(const Json::Value& v)
   {
     throw std::runtime_error(HL_DEBUG + " invalid type for v, expecting an object");
   }
-  std::string file_path;
+  std::string file_path, log_path;
   std::vector<int> ports;
   tryReadVal(v, "file_path", &file_path);
+  tryReadVal(v, "log_path", &log_path);
   if (v.isMember("ports"))
   {
     if (!v["ports"].isArray())
@@ -196,24 +228,29 @@ void MonitoringManager::loadMessageManager(const Json::Value& v)
       ports.push_back(v["ports"][idx].asInt());
     }
   }
-  bool ports_set = ports.size() != 0;
-  bool file_path_set = file_path != "";
-  if (!ports_set && !file_path_set)
+  int nb_sources = (ports.size() != 0) + (file_path != "") + (log_path != "");
+  if (nb_sources == 0)
   {
-    throw std::runtime_error(HL_DEBUG + " neither 'ports' nor 'file_path' provided");
+    throw std::runtime_error(HL_DEBUG + " none of 'ports', 'file_path' and 'log_path' provided");
   }
-  else if (ports_set && file_path_set)
+  else if (nb_sources > 1)
   {
-    throw std::runtime_error(HL_DEBUG + " both 'ports' and 'file_path' provided");
+    throw std::runtime_error(HL_DEBUG + " only one of 'ports', 'file_path' and 'log_path' can be provided");
   }
-  if (ports_set)
+  if (ports.size() != 0)
   {
     message_manager.reset(new MessageManager(ports));
+    return;
   }
-  else
+  if (log_path != "")
   {
-    message_manager.reset(new MessageManager(file_path));
+    // MessageManager reads a single collection: segments are merged once and the result is reused by 'file_path'
+    MessageCollection messages;
+    readMessageLog(log_path, &messages);
+    file_path = log_path + ".bin";
+    writeToFile(file_path, messages);
   }
+  message_manager.reset(new MessageManager(file_path));
 }
 
 void MonitoringManager::setMessageManager(std::unique_ptr<MessageManager> new_message_manager)
@@ -221,13 +258,15 @@ void MonitoringManager::setMessageManager(std::unique_ptr<MessageManager> new_me
   message_manager = std::move(new_message_manager);
 }
 
-void MonitoringManager::addImageProvider(const std::string& name, std::unique_ptr<ImageProvider> image_provider)
+void MonitoringManager::addImageProvider(const std::string& name, std::unique_ptr<ImageProvider> image_provider,
+                                         const ImageProviderFactory::Capabilities& capabilities)
 {
   if (image_providers.count(name) > 0)
   {
     throw std::logic_error("Failed to add Image Provider: '" + name + "' already in collection");
   }
   image_providers[name] = std::move(image_provider);
+  providers_capabilities[name] = capabilities;
   if (live)
   {
     image_providers[name]->setExternalName(name);
@@ -236,11 +275,66 @@ void MonitoringManager::addImageProvider(const std::string& name, std::unique_pt
 
 void MonitoringManager::update()
 {
+  ScopedTimer timer("MonitoringManager::update");
+  std::vector<std::function<void()>> tasks;
   for (const auto& entry : image_providers)
   {
-    entry.second->update();
+    // Providers which do not acquire images have nothing to do
+    if (!providers_capabilities.at(entry.first).live)
+    {
+      continue;
+    }
+    // Frames requested in advance for other providers are left to getSynchronizedImages and its deadline
+    waitPendingFrame(entry.first);
+    ImageProvider* provider = entry.second.get();
+    std::string stage = "ImageProvider::update[" + entry.first + "]";
+    tasks.push_back([provider, stage]() {
+      ScopedTimer provider_timer(stage);
+      provider->update();
+    });
+  }
+  // Frames of the providers rendering the field have been collected above, no task reads the field while it changes
+  field.pullDimensions();
+  runTasks(tasks);
+  for (const auto& entry : image_providers)
+  {
+    Profiler::getDefault().setCounter("dropped_frames[" + entry.first + "]", entry.second->getNbDroppedFrames());
+  }
+  if (live && retention_window > 0)
+  {
+    uint64_t now = getTimeStamp();
+    uint64_t window = retention_window * 1000 * 1000;
+    for (const auto& entry : image_providers)
+    {
+      ImageProvider* provider = entry.second.get();
+      if (!providers_capabilities.at(entry.first).live)
+      {
+        continue;
+      }
+      if (provider->getNbFrames() > 0 && now > provider->getStart() + retention_margin * window)
+      {
+        provider->discardFramesBefore(now - window);
+      }
+    }
+  }
+  ScopedTimer message_timer("MessageManager::update");
+  MessageCollection received;
+  message_manager->update(&received);
+  if (live && output_prefix != "")
+  {
+    std::lock_guard<std::mutex> lock(pending_mutex);
+    pending_messages.MergeFrom(received);
+  }
+  if (live && retention_window > 0)
+  {
+    // Messages are copied to pending_messages on reception, discarding them does not remove them from the log
+    uint64_t now = getTimeStamp();
+    uint64_t window = retention_window * 1000 * 1000;
+    if (now > message_manager->getStart() + retention_margin * window)
+    {
+      message_manager->discardMessagesBefore(now - window);
+    }
   }
-  message_manager->update();
 }
 
 CalibratedImage MonitoringManager::getCalibratedImage(const std::string& provider_name, uint64_t time_stamp)
@@ -249,22 +343,340 @@ CalibratedImage MonitoringManager::getCalibratedImage(const std::string& provide
   {
     throw std::out_of_range(HL_DEBUG + " no image provider named '" + provider_name + "'");
   }
-  return image_providers.at(provider_name)->getCalibratedImage(time_stamp);
+  waitPendingFrames();
+  return image_providers.at(provider_name)->getImage(time_stamp);
 }
 
 std::map<std::string, CalibratedImage> MonitoringManager::getCalibratedImages(uint64_t time_stamp)
 {
+  ScopedTimer timer("MonitoringManager::getCalibratedImages");
+  waitPendingFrames();
   std::map<std::string, CalibratedImage> images;
+  std::vector<std::function<void()>> tasks;
   for (const auto& entry : image_providers)
   {
     if (entry.second->getStart() <= time_stamp)
     {
-      images[entry.first] = entry.second->getCalibratedImage(time_stamp);
+      // Entries are created before running the tasks, each task only writes in its own entry
+      CalibratedImage* img = &(images[entry.first]);
+      ImageProvider* provider = entry.second.get();
+      tasks.push_back([img, provider, time_stamp]() { *img = provider->getImage(time_stamp); });
+    }
+  }
+  runTasks(tasks);
+  return images;
+}
+
+std::map<std::string, CalibratedImage> MonitoringManager::getSynchronizedImages(uint64_t time_stamp)
+{
+  if (live || nb_threads == 1)
+  {
+    return getCalibratedImages(time_stamp);
+  }
+  ScopedTimer timer("MonitoringManager::getSynchronizedImages");
+  std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::now() + std::chrono::microseconds(max_latency);
+  const std::chrono::steady_clock::time_point* deadline_ptr = max_latency > 0 ? &deadline : nullptr;
+  // Frames which were not requested in advance are requested first, so that all providers work in parallel
+  std::map<std::string, int> wished_indices;
+  for (const auto& entry : image_providers)
+  {
+    ImageProvider* provider = entry.second.get();
+    if (provider->getStart() > time_stamp)
+    {
+      continue;
+    }
+    int frame_index = provider->getIndex(time_stamp);
+    if (frame_index < 0)
+    {
+      continue;
+    }
+    wished_indices[entry.first] = frame_index;
+    StreamPlayback* stream = &(playback_streams[entry.first]);
+    if (stream->delivered_index == frame_index || stream->pending_index == frame_index)
+    {
+      continue;
+    }
+    if (stream->pending_index >= 0)
+    {
+      // Providers handle a single request at a time: the wrong frame requested in advance has to be retrieved first
+      const std::chrono::steady_clock::time_point* stream_deadline = deadline_ptr;
+      if (stream->delivered_index < 0)
+      {
+        stream_deadline = nullptr;
+      }
+      if (!collectFrame(stream, stream_deadline))
+      {
+        continue;
+      }
+    }
+    requestFrame(provider, frame_index, stream);
+  }
+  std::map<std::string, CalibratedImage> images;
+  for (const auto& entry : wished_indices)
+  {
+    StreamPlayback* stream = &(playback_streams[entry.first]);
+    if (stream->pending_index == entry.second)
+    {
+      // Until a first frame has been delivered, there is no frame to use as a replacement
+      collectFrame(stream, stream->delivered_index < 0 ? nullptr : deadline_ptr);
+    }
+    if (stream->delivered_index != entry.second)
+    {
+      Profiler::getDefault().increment("late_frames[" + entry.first + "]");
+    }
+    if (stream->delivered_index >= 0)
+    {
+      images[entry.first] = stream->delivered_img;
     }
   }
+  // Frames expected for next call are requested, assuming time progresses at the same pace
+  if (last_playback_time != 0 && last_playback_time != time_stamp)
+  {
+    bool forward = time_stamp > last_playback_time;
+    uint64_t step = forward ? time_stamp - last_playback_time : last_playback_time - time_stamp;
+    if (step < max_playback_step && (forward || step <= time_stamp))
+    {
+      uint64_t next_time_stamp = forward ? time_stamp + step : time_stamp - step;
+      for (const auto& entry : wished_indices)
+      {
+        StreamPlayback* stream = &(playback_streams[entry.first]);
+        ImageProvider* provider = image_providers.at(entry.first).get();
+        // Requesting a frame in advance from a provider which cannot seek would modify the current frame
+        bool seekable = providers_capabilities.at(entry.first).seekable;
+        if (stream->pending_index >= 0 || stream->delivered_index < 0 || !seekable)
+        {
+          continue;
+        }
+        int next_index = provider->getIndex(next_time_stamp);
+        // Even if the next call is expected to use the same frame, the following one will be required soon
+        if (forward)
+        {
+          next_index = std::max(next_index, stream->delivered_index + 1);
+        }
+        else
+        {
+          next_index = std::min(next_index, stream->delivered_index - 1);
+        }
+        if (next_index >= 0 && next_index < (int)provider->getNbFrames())
+        {
+          requestFrame(provider, next_index, stream);
+        }
+      }
+    }
+  }
+  last_playback_time = time_stamp;
   return images;
 }
 
+void MonitoringManager::setMaxLatency(uint64_t new_max_latency)
+{
+  max_latency = new_max_latency;
+}
+
+PlaybackClock& MonitoringManager::getPlaybackClock()
+{
+  return playback_clock;
+}
+
+void MonitoringManager::saveMessages()
+{
+  if (output_prefix == "")
+  {
+    throw std::logic_error(HL_DEBUG + " no output directory to save messages");
+  }
+  ScopedTimer timer("MonitoringManager::saveMessages");
+  std::lock_guard<std::mutex> log_lock(message_log_mutex);
+  MessageCollection messages;
+  {
+    std::lock_guard<std::mutex> lock(pending_mutex);
+    messages.Swap(&pending_messages);
+  }
+  try
+  {
+    if (!message_log.isOpened())
+    {
+      message_log.open(output_prefix + "messages");
+    }
+    message_log.append(messages);
+  }
+  catch (const std::exception&)
+  {
+    // Messages are written by the next save, before the ones received in the meantime
+    std::lock_guard<std::mutex> lock(pending_mutex);
+    messages.MergeFrom(pending_messages);
+    pending_messages.Swap(&messages);
+    throw;
+  }
+}
+
+void MonitoringManager::setRetentionWindow(double duration)
+{
+  if (duration < 0)
+  {
+    throw std::out_of_range(HL_DEBUG + " invalid retention window: " + std::to_string(duration));
+  }
+  retention_window = duration;
+}
+
+void MonitoringManager::setMessagesSavePeriod(double period)
+{
+  if (period < 0)
+  {
+    throw std::out_of_range(HL_DEBUG + " invalid period: " + std::to_string(period));
+  }
+  messages_save_period = period;
+}
+
+void MonitoringManager::startMessagesPersistence()
+{
+  if (!live || output_prefix == "" || messages_save_period <= 0 || messages_persistence_thread.joinable())
+  {
+    return;
+  }
+  persistence_stop = false;
+  messages_persistence_thread = std::thread(&MonitoringManager::runMessagesPersistence, this);
+}
+
+void MonitoringManager::stopMessagesPersistence()
+{
+  if (!messages_persistence_thread.joinable())
+  {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(persistence_mutex);
+    persistence_stop = true;
+  }
+  persistence_stop_requested.notify_all();
+  messages_persistence_thread.join();
+}
+
+void MonitoringManager::runMessagesPersistence()
+{
+  std::chrono::microseconds period((int64_t)(messages_save_period * 1000 * 1000));
+  std::unique_lock<std::mutex> lock(persistence_mutex);
+  while (!persistence_stop_requested.wait_for(lock, period, [this]() { return persistence_stop; }))
+  {
+    lock.unlock();
+    try
+    {
+      saveMessages();
+    }
+    catch (const std::exception& exc)
+    {
+      // Next save might succeed, messages are kept until then
+      std::cerr << HL_DEBUG << "Failed to save messages: " << exc.what() << std::endl;
+    }
+    lock.lock();
+  }
+}
+
+void MonitoringManager::setNbThreads(int new_nb_threads)
+{
+  if (new_nb_threads < 0)
+  {
+    throw std::out_of_range(HL_DEBUG + " invalid number of threads: " + std::to_string(new_nb_threads));
+  }
+  waitPendingFrames();
+  nb_threads = new_nb_threads;
+  thread_pool.reset();
+}
+
+void MonitoringManager::requestFrame(ImageProvider* provider, int frame_index, StreamPlayback* stream)
+{
+  uint64_t frame_time_stamp = provider->getTimeStamp(frame_index);
+  stream->pending_index = frame_index;
+  stream->pending_img =
+      getThreadPool().submit([provider, frame_time_stamp]() { return provider->getImage(frame_time_stamp); });
+}
+
+bool MonitoringManager::collectFrame(StreamPlayback* stream, const std::chrono::steady_clock::time_point* deadline)
+{
+  if (deadline != nullptr && stream->pending_img.wait_until(*deadline) != std::future_status::ready)
+  {
+    return false;
+  }
+  int frame_index = stream->pending_index;
+  stream->pending_index = -1;
+  // If retrieval failed, the exception is forwarded to the caller
+  stream->delivered_img = stream->pending_img.get();
+  stream->delivered_index = frame_index;
+  return true;
+}
+
+void MonitoringManager::waitPendingFrames()
+{
+  for (auto& entry : playback_streams)
+  {
+    if (entry.second.pending_index >= 0)
+    {
+      collectFrame(&(entry.second), nullptr);
+    }
+  }
+}
+
+void MonitoringManager::waitPendingFrame(const std::string& provider_name)
+{
+  auto it = playback_streams.find(provider_name);
+  if (it != playback_streams.end() && it->second.pending_index >= 0)
+  {
+    collectFrame(&(it->second), nullptr);
+  }
+}
+
+ThreadPool& MonitoringManager::getThreadPool()
+{
+  if (!thread_pool)
+  {
+    size_t pool_size = nb_threads;
+    if (nb_threads == 0)
+    {
+      pool_size = std::min(image_providers.size(), (size_t)std::max(1u, std::thread::hardware_concurrency()));
+    }
+    thread_pool.reset(new ThreadPool(pool_size));
+  }
+  return *thread_pool;
+}
+
+void MonitoringManager::runTasks(const std::vector<std::function<void()>>& tasks)
+{
+  if (nb_threads == 1 || tasks.size() <= 1)
+  {
+    for (const auto& task : tasks)
+    {
+      task();
+    }
+    return;
+  }
+  ThreadPool& pool = getThreadPool();
+  std::vector<std::future<void>> results;
+  for (const auto& task : tasks)
+  {
+    results.push_back(pool.submit(task));
+  }
+  // All tasks have to be finished before returning since they access the providers
+  std::exception_ptr error;
+  for (std::future<void>& result : results)
+  {
+    try
+    {
+      result.get();
+    }
+    catch (...)
+    {
+      if (!error)
+      {
+        error = std::current_exception();
+      }
+    }
+  }
+  if (error)
+  {
+    std::rethrow_exception(error);
+  }
+}
+
 const hl_communication::MessageManager& MonitoringManager::getMessageManager() const
 {
   if (!message_manager)
@@ -283,6 +695,15 @@ const ImageProvider& MonitoringManager::getImageProvider(const std::string& name
   return *(image_providers.at(name));
 }
 
+const ImageProviderFactory::Capabilities& MonitoringManager::getImageProviderCapabilities(const std::string& name) const
+{
+  if (providers_capabilities.count(name) == 0)
+  {
+    throw std::out_of_range(HL_DEBUG + " no image provider named '" + name + "'");
+  }
+  return providers_capabilities.at(name);
+}
+
 std::set<std::string> MonitoringManager::getImageProvidersNames() const
 {
   std::set<std::string> names;
@@ -321,6 +742,7 @@ bool MonitoringManager::isLive() const
 
 void MonitoringManager::setOffset(int64 offset)
 {
+  waitPendingFrames();
   if (message_manager)
   {
     message_manager->setOffset(offset);
@@ -369,7 +791,10 @@ const TeamManager& MonitoringManager::getTeamManager() const
 
 void MonitoringManager::setPose(const std::string& provider_name, int frame_idx, const Pose3D& pose)
 {
+  waitPendingFrames();
   image_providers.at(provider_name)->setPose(frame_idx, pose);
+  // Delivered frame might use the previous pose
+  playback_streams.erase(provider_name);
 }
 
 }  // namespace hl_monitoring
@@ -2,11 +2,21 @@
 
 #include <hl_monitoring/field.h>
 #include <hl_monitoring/image_provider.h>
+#include <hl_monitoring/image_provider_factory.h>
+#include <hl_monitoring/message_log.h>
+#include <hl_monitoring/playback_clock.h>
 #include <hl_monitoring/team_manager.h>
+#include <hl_monitoring/thread_pool.h>
 #include <hl_communication/message_manager.h>
 
 #include <json/json.h>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <thread>
 
 namespace hl_monitoring
 {
@@ -40,18 +50,78 @@ public:
   void setupOutput();
   void dumpReplayConfig();
 
+  /**
+   * Build the provider described in v with the default ImageProviderFactory, files written by the provider are
+   * prefixed by its name
+   */
   std::unique_ptr<ImageProvider> buildImageProvider(const Json::Value& v, const std::string& name);
   void loadImageProviders(const Json::Value& v);
   void loadMessageManager(const Json::Value& v);
 
   void setMessageManager(std::unique_ptr<hl_communication::MessageManager> message_manager);
-  void addImageProvider(const std::string& name, std::unique_ptr<ImageProvider> image_provider);
+  /**
+   * Add a provider to the collection, its capabilities are used to choose how it is scheduled
+   */
+  void addImageProvider(const std::string& name, std::unique_ptr<ImageProvider> image_provider,
+                        const ImageProviderFactory::Capabilities& capabilities = ImageProviderFactory::Capabilities());
 
+  /**
+   * Apply the dimensions of the field tuned over RhIO, update all the image providers, in parallel if several threads
+   * are allowed, then update the message manager
+   */
   void update();
 
   CalibratedImage getCalibratedImage(const std::string& provider_name, uint64_t time_stamp);
+  /**
+   * Retrieve the images of all the providers which started before time_stamp, each provider being handled by a
+   * different task if several threads are allowed.
+   */
   std::map<std::string, CalibratedImage> getCalibratedImages(uint64_t time_stamp);
 
+  /**
+   * Retrieve the images of all the providers which started before time_stamp for synchronized playback.
+   *
+   * Each provider delivers the frame it contains at time_stamp. Frames expected for the next call are requested in
+   * advance, in parallel for all the providers, based on the progression of time_stamp between two calls. If a maximal
+   * latency is set and a frame is not available in time, the last frame delivered by this provider is used instead.
+   */
+  std::map<std::string, CalibratedImage> getSynchronizedImages(uint64_t time_stamp);
+
+  /**
+   * Maximal duration spent waiting for frames in getSynchronizedImages [us], 0 means no limit
+   */
+  void setMaxLatency(uint64_t max_latency);
+
+  /**
+   * Global timeline used to replay all the streams together
+   */
+  PlaybackClock& getPlaybackClock();
+
+  /**
+   * Append the messages received since the previous save to the message log in the 'messages' directory of the output
+   * folder, see MessageLogWriter. The cost of a save only depends on the number of messages received since the
+   * previous one and update() is never blocked while they are written.
+   */
+  void saveMessages();
+
+  /**
+   * Period between two automatic saves of the messages in live mode [s], 0 disables automatic saves: messages are
+   * then only saved when the manager is destroyed.
+   */
+  void setMessagesSavePeriod(double period);
+
+  /**
+   * Duration of the history kept in memory by the image providers and the message manager in live mode [s], older
+   * frames and messages are only available on disk. 0 keeps all the frames and messages in memory.
+   */
+  void setRetentionWindow(double duration);
+
+  /**
+   * Set the maximal number of threads used to access the image providers, 0 uses one thread per provider up to the
+   * number of hardware threads, 1 disables parallel access.
+   */
+  void setNbThreads(int nb_threads);
+
   const hl_communication::MessageManager& getMessageManager() const;
 
   /**
@@ -60,6 +130,11 @@ public:
    */
   const ImageProvider& getImageProvider(const std::string& name) const;
 
+  /**
+   * throws std::out_of_range if name is not valid.
+   */
+  const ImageProviderFactory::Capabilities& getImageProviderCapabilities(const std::string& name) const;
+
   std::set<std::string> getImageProvidersNames() const;
 
   /**
@@ -89,6 +164,71 @@ public:
   void setPose(const std::string& provider_name, int frame_idx, const hl_communication::Pose3D& pose);
 
 private:
+  /**
+   * Playback state of a provider during synchronized playback
+   */
+  struct StreamPlayback
+  {
+    StreamPlayback();
+
+    /**
+     * Index of the frame being retrieved, -1 if no frame is being retrieved
+     */
+    int pending_index;
+
+    std::future<CalibratedImage> pending_img;
+
+    /**
+     * Index of the last frame delivered, -1 if no frame has been delivered yet
+     */
+    int delivered_index;
+
+    CalibratedImage delivered_img;
+  };
+
+  /**
+   * Start the retrieval of the given frame by a worker, no other frame may be pending for this stream
+   */
+  void requestFrame(ImageProvider* provider, int frame_index, StreamPlayback* stream);
+
+  /**
+   * Wait until the pending frame of the stream is retrieved and make it the delivered frame. If the deadline is
+   * reached before, returns false and the stream is not modified.
+   */
+  bool collectFrame(StreamPlayback* stream, const std::chrono::steady_clock::time_point* deadline);
+
+  /**
+   * Wait until all the frames requested in advance are retrieved, required before accessing the providers directly
+   */
+  void waitPendingFrames();
+
+  /**
+   * Wait until the frame requested in advance for the given provider is retrieved, if there is one
+   */
+  void waitPendingFrame(const std::string& provider_name);
+
+  /**
+   * Start the thread saving the messages periodically if required (live mode with an output directory)
+   */
+  void startMessagesPersistence();
+  void stopMessagesPersistence();
+
+  /**
+   * Main loop of the thread saving the messages
+   */
+  void runMessagesPersistence();
+
+  /**
+   * Return the workers used to access the providers, creating them if necessary
+   */
+  ThreadPool& getThreadPool();
+
+  /**
+   * Run the tasks, in parallel if allowed, and wait until all of them are finished. If some tasks failed, the
+   * exception raised by the first of them in the vector is rethrown.
+   */
+  void runTasks(const std::vector<std::function<void()>>& tasks);
+
   /**
    * Access to message from both, robots and GameController
    */
@@ -99,6 +239,11 @@ private:
    */
   std::map<std::string, std::unique_ptr<ImageProvider>> image_providers;
 
+  /**
+   * Capabilities of the image providers, indexed by name
+   */
+  std::map<std::string, ImageProviderFactory::Capabilities> providers_capabilities;
+
   /**
    * Dimensions of the field
    */
@@ -119,6 +264,69 @@ private:
    * if empty, then nothing is saved
    */
   std::string output_prefix;
+
+  /**
+   * Maximal number of threads used to access the image providers, see setNbThreads
+   */
+  int nb_threads;
+
+  /**
+   * Workers accessing the image providers, created on first use
+   */
+  std::unique_ptr<ThreadPool> thread_pool;
+
+  PlaybackClock playback_clock;
+
+  /**
+   * Maximal duration spent waiting for frames in getSynchronizedImages [us], 0 means no limit
+   */
+  uint64_t max_latency;
+
+  /**
+   * Time stamp of the last call to getSynchronizedImages, 0 if there was no call
+   */
+  uint64_t last_playback_time;
+
+  std::map<std::string, StreamPlayback> playback_streams;
+
+  /**
+   * Duration of the history kept in memory in live mode [s], see setRetentionWindow
+   */
+  double retention_window;
+
+  /**
+   * Period between two automatic saves of the messages [s]
+   */
+  double messages_save_period;
+
+  /**
+   * Messages received by update() since the last save
+   */
+  hl_communication::MessageCollection pending_messages;
+
+  /**
+   * Protects pending_messages, only held while moving messages in or out
+   */
+  std::mutex pending_mutex;
+
+  /**
+   * Segmented log of the messages received in live mode, opened on first save
+   */
+  MessageLogWriter message_log;
+
+  /**
+   * Ensures that saves are written to the log in the order of reception
+   */
+  std::mutex message_log_mutex;
+
+  std::thread messages_persistence_thread;
+
+  /**
+   * Protects the members below, used to communicate with the thread saving the messages
+   */
+  std::mutex persistence_mutex;
+  std::condition_variable persistence_stop_requested;
+  bool persistence_stop;
 };
 
 }  // namespace hl_monitoring
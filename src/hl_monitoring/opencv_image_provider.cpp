@@ -1,27 +1,52 @@
 #include "hl_monitoring/opencv_image_provider.h"
+#include "hl_monitoring/image_provider_factory.h"
+#include "hl_monitoring/meta_information_log.h"
 
 #include <hl_communication/utils.h>
 
 #include <chrono>
-#include <fstream>
+#include <sstream>
 
 using namespace std::chrono;
 using namespace hl_communication;
 
 namespace hl_monitoring
 {
+static std::unique_ptr<ImageProvider> buildOpenCVImageProvider(const Json::Value& v,
+                                                               const ImageProviderFactory::BuildContext& context)
+{
+  std::string input_path;
+  bool async_capture = false;
+  int capture_buffer_size = 8;
+  checkMember(v, "input_path");
+  readVal(v, "input_path", &input_path);
+  tryReadVal(v, "async_capture", &async_capture);
+  tryReadVal(v, "capture_buffer_size", &capture_buffer_size);
+  std::unique_ptr<OpenCVImageProvider> provider(new OpenCVImageProvider(input_path, context.output_prefix));
+  if (v.isMember("writer"))
+  {
+    provider->getVideoWriter().fromJson(v["writer"]);
+  }
+  if (async_capture)
+  {
+    provider->startCaptureThread(capture_buffer_size);
+  }
+  return provider;
+}
+
+static ImageProviderFactory::Registrar registrar("OpenCVImageProvider", buildOpenCVImageProvider,
+                                                 ImageProviderFactory::Capabilities(true, false, true));
+
 OpenCVImageProvider::OpenCVImageProvider(const std::string& video_path, const std::string& output_prefix_)
   : output_prefix(output_prefix_)
 {
   openInputStream(video_path);
-  if (output_prefix != "")
-  {
-    openOutputStream(output_prefix + ".avi");
-  }
 }
 OpenCVImageProvider::~OpenCVImageProvider()
 {
+  stopCaptureThread();
   saveVideoMetaInformation();
+  output.close();
 }
 
 double OpenCVImageProvider::getFPS() const
@@ -61,11 +86,61 @@ void OpenCVImageProvider::openOutputStream(const std::string& output_path)
   }
   double fps = getFPS();
   bool use_color = true;
-  output.open(output_path, cv::VideoWriter::fourcc('X', 'V', 'I', 'D'), fps, img_size, use_color);
-  if (!output.isOpened())
+  output.open(output_path, output.getFourcc(), fps, img_size, use_color);
+}
+
+void OpenCVImageProvider::startCaptureThread(size_t buffer_size)
+{
+  if (capture_thread)
   {
-    throw std::runtime_error(HL_DEBUG + "Failed to open video");
+    throw std::logic_error(HL_DEBUG + " capture thread is already running");
+  }
+  if (!input.isOpened())
+  {
+    throw std::logic_error(HL_DEBUG + " input stream is not open yet");
   }
+  capture_thread.reset(new CaptureThread([this](TimedFrame* frame) { this->grabFrame(frame); }, buffer_size));
+  capture_thread->start();
+}
+
+void OpenCVImageProvider::stopCaptureThread()
+{
+  if (!capture_thread)
+  {
+    return;
+  }
+  capture_thread->stop();
+  // Frames acquired before stopping are still registered
+  TimedFrame frame;
+  while (capture_thread->pop(&frame))
+  {
+    registerFrame(frame);
+  }
+  capture_thread.reset();
+}
+
+uint64_t OpenCVImageProvider::getNbDroppedFrames() const
+{
+  uint64_t nb_dropped = output.getStatistics().nb_dropped;
+  if (capture_thread)
+  {
+    nb_dropped += capture_thread->getNbDroppedFrames();
+  }
+  return nb_dropped;
+}
+
+VideoWriterStage& OpenCVImageProvider::getVideoWriter()
+{
+  return output;
+}
+
+std::string OpenCVImageProvider::getOutputVideoPath() const
+{
+  if (output_prefix == "")
+  {
+    return "";
+  }
+  return output.getVideoPath(output_prefix);
 }
 
 void OpenCVImageProvider::restartStream()
@@ -79,46 +154,75 @@ CalibratedImage OpenCVImageProvider::getCalibratedImage(uint64_t time_stamp)
   {
     throw std::runtime_error(HL_DEBUG + " no frames found in the stream");
   }
-  uint64_t last_frame = indices_by_time_stamp.rbegin()->first;
+  uint64_t last_frame = getEnd();
   if (time_stamp < last_frame)
   {
     throw std::runtime_error(HL_DEBUG + " asking for frames in the past is not supported (current_index:) " +
                              std::to_string(last_frame));
   }
 
-  int index = indices_by_time_stamp.size() - 1;
-  return CalibratedImage(img, getCameraMetaInformation(index));
+  return CalibratedImage(img, getSharedCameraMetaInformation(index));
 }
 
 void OpenCVImageProvider::update()
 {
-  // TODO: note: ideally, images should be polled in another thread and only
-  // synchronization should happen here
-  getNextImg();
+  if (!capture_thread)
+  {
+    getNextImg();
+    return;
+  }
+  // Only synchronization happens here: register all the frames acquired since last update
+  TimedFrame frame;
+  while (capture_thread->pop(&frame))
+  {
+    registerFrame(frame);
+  }
 }
 
 cv::Mat OpenCVImageProvider::getNextImg()
 {
-  input.read(img);
+  TimedFrame frame;
+  if (capture_thread)
+  {
+    capture_thread->waitFrame(&frame);
+  }
+  else
+  {
+    grabFrame(&frame);
+  }
+  return registerFrame(frame);
+}
 
-  uint64_t monotonic_ts = hl_communication::getTimeStamp();
-  uint64_t utc_ts = hl_communication::getUTCTimeStamp();
-  if (img.empty())
+void OpenCVImageProvider::grabFrame(TimedFrame* frame)
+{
+  input.read(frame->img);
+  frame->monotonic_ts = hl_communication::getTimeStamp();
+  frame->utc_ts = hl_communication::getUTCTimeStamp();
+  if (frame->img.empty())
   {
-    throw std::runtime_error(HL_DEBUG + "Blank frame at frame: " + std::to_string(index) + "/" +
-                             std::to_string(nb_frames));
+    throw std::runtime_error(HL_DEBUG + "Blank frame received from input stream");
   }
-  // register image
-  pushTimeStamp(index, monotonic_ts);
+}
+
+cv::Mat OpenCVImageProvider::registerFrame(const TimedFrame& frame)
+{
+  img = frame.img;
+  index = nb_frames;
+  pushTimeStamp(index, frame.monotonic_ts);
   FrameEntry* entry = meta_information.add_frames();
-  entry->set_utc_ts(utc_ts);
-  entry->set_monotonic_ts(monotonic_ts);
-  index++;
+  entry->set_utc_ts(frame.utc_ts);
+  entry->set_monotonic_ts(frame.monotonic_ts);
   nb_frames++;
-  // Write image to output video if opened
+  // Output stream is opened with the first image, once the configuration of the writer is known
+  if (output_prefix != "" && !output.isOpened())
+  {
+    openOutputStream(getOutputVideoPath());
+    output.openMetaInformation(output_prefix + ".bin", extractHeader(&meta_information));
+  }
+  // Queue image for the output video if opened
   if (output.isOpened())
   {
-    output.write(img);
+    output.push(img, *entry);
   }
   return img;
 }
@@ -133,17 +237,18 @@ void OpenCVImageProvider::saveVideoMetaInformation()
   // Do not save if no output_prefix has been provided
   if (output_prefix == "")
     return;
+  output.writeHeader(extractHeader(&meta_information));
+}
 
-  std::string path = output_prefix + ".bin";
-  std::ofstream out(path, std::ios::binary);
-  if (!out.good())
-  {
-    throw std::runtime_error(HL_DEBUG + "Failed to open file '" + path + "'");
-  }
-  if (!meta_information.SerializeToOstream(&out))
-  {
-    throw std::runtime_error(HL_DEBUG + "Failed to write to file '" + path + "'");
-  }
+void OpenCVImageProvider::onHeaderChange()
+{
+  saveVideoMetaInformation();
+}
+
+void OpenCVImageProvider::onFrameChange(const FrameEntry& entry)
+{
+  // Entry has already been pushed to the writer, the update is applied when reading the meta information
+  output.writeFrameUpdate(entry);
 }
 
 }  // namespace hl_monitoring
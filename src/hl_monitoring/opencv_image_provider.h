@@ -1,22 +1,27 @@
 #pragma once
 
+#include "hl_monitoring/capture_thread.h"
 #include "hl_monitoring/image_provider.h"
+#include "hl_monitoring/video_writer_stage.h"
 
 #include <opencv2/videoio.hpp>
 
+#include <memory>
+
 namespace hl_monitoring
 {
 /**
  * Use OpenCV standard API to open a video stream
  * - Images read can be directly encoded in a video
  * - Timestamps are based on the steady clock acquisition time, not time_since_epoch
+ * - Images can be polled in a dedicated thread (see startCaptureThread), in this case 'update' only retrieves the
+ *   images already acquired
  */
 class OpenCVImageProvider : public ImageProvider
 {
 public:
   /**
-   * If output_prefix is not empty, write video during execution and saves
-   * MetaInformation when object is closed
+   * If output_prefix is not empty, write video and MetaInformation during execution
    */
   OpenCVImageProvider(const std::string& video_path, const std::string& output_prefix = "");
   virtual ~OpenCVImageProvider();
@@ -26,6 +31,30 @@ public:
   void openInputStream(const std::string& video_path);
   void openOutputStream(const std::string& output_path);
 
+  /**
+   * Start polling the images of the input stream in a dedicated thread. Up to 'buffer_size' images are stored while
+   * waiting to be consumed by 'update' or 'getNextImg'.
+   */
+  void startCaptureThread(size_t buffer_size = 8);
+
+  /**
+   * Stop the dedicated capture thread if it is running, images are then read synchronously again
+   */
+  void stopCaptureThread();
+
+  /**
+   * Number of images acquired by the capture thread which could not be stored because the buffer was full, plus the
+   * number of images dropped by the video writer
+   */
+  uint64_t getNbDroppedFrames() const override;
+
+  /**
+   * Access to the stage encoding the output video, allows to configure its queue
+   */
+  VideoWriterStage& getVideoWriter();
+
+  std::string getOutputVideoPath() const override;
+
   void restartStream() override;
 
   CalibratedImage getCalibratedImage(uint64_t time_stamp) override;
@@ -36,18 +65,36 @@ public:
 
   bool isStreamFinished() override;
 
+  /**
+   * Write the information shared by all the frames to the meta information file, frames are written as soon as they
+   * are encoded
+   */
   void saveVideoMetaInformation();
 
+protected:
+  void onHeaderChange() override;
+  void onFrameChange(const hl_communication::FrameEntry& entry) override;
+
 private:
+  /**
+   * Read an image from the input stream and tag it with the acquisition time
+   */
+  void grabFrame(TimedFrame* frame);
+
+  /**
+   * Store the information relative to the frame, write it to the output video if opened and return its image
+   */
+  cv::Mat registerFrame(const TimedFrame& frame);
+
   /**
    * The video read from the file
    */
   cv::VideoCapture input;
 
   /**
-   * The video read from the file
+   * Encodes the images received in a video, from its own thread
    */
-  cv::VideoWriter output;
+  VideoWriterStage output;
 
   /**
    * Last img read
@@ -64,6 +111,11 @@ private:
    * then no files are written
    */
   std::string output_prefix;
+
+  /**
+   * The thread polling images from the input stream, null if images are read synchronously
+   */
+  std::unique_ptr<CaptureThread> capture_thread;
 };
 
 }  // namespace hl_monitoring
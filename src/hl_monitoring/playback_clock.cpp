@@ -0,0 +1,75 @@
+#include "hl_monitoring/playback_clock.h"
+
+#include <hl_communication/utils.h>
+
+#include <cmath>
+
+using namespace hl_communication;
+
+namespace hl_monitoring
+{
+PlaybackClock::PlaybackClock() : reference_time(0), reference_steady_time(getTimeStamp()), speed(1.0), paused(true)
+{
+}
+
+uint64_t PlaybackClock::getTime() const
+{
+  if (paused)
+  {
+    return reference_time;
+  }
+  int64_t delta = std::llround(getElapsed() * speed);
+  if (delta < 0 && (uint64_t)(-delta) > reference_time)
+  {
+    return 0;
+  }
+  return reference_time + delta;
+}
+
+void PlaybackClock::seek(uint64_t time_stamp)
+{
+  reference_time = time_stamp;
+  reference_steady_time = getTimeStamp();
+}
+
+void PlaybackClock::play()
+{
+  if (paused)
+  {
+    reference_steady_time = getTimeStamp();
+    paused = false;
+  }
+}
+
+void PlaybackClock::pause()
+{
+  if (!paused)
+  {
+    seek(getTime());
+    paused = true;
+  }
+}
+
+bool PlaybackClock::isPaused() const
+{
+  return paused;
+}
+
+void PlaybackClock::setSpeed(double new_speed)
+{
+  // Changing the speed should not move the replay
+  seek(getTime());
+  speed = new_speed;
+}
+
+double PlaybackClock::getSpeed() const
+{
+  return speed;
+}
+
+int64_t PlaybackClock::getElapsed() const
+{
+  return (int64_t)(getTimeStamp() - reference_steady_time);
+}
+
+}  // namespace hl_monitoring
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+
+namespace hl_monitoring
+{
+/**
+ * Global timeline used to replay several streams together.
+ *
+ * The time of the replay advances with the steady clock multiplied by the playback speed, it is shared by all the
+ * streams so that they do not drift relatively to each other, whatever the time spent to retrieve their images.
+ */
+class PlaybackClock
+{
+public:
+  PlaybackClock();
+
+  /**
+   * Return the current time of the replay [us]
+   */
+  uint64_t getTime() const;
+
+  /**
+   * Move the replay to the given time [us], playing state is not modified
+   */
+  void seek(uint64_t time_stamp);
+
+  void play();
+  void pause();
+  bool isPaused() const;
+
+  /**
+   * Ratio between the elapsed replay time and the elapsed real time, negative values play backward
+   */
+  void setSpeed(double speed);
+  double getSpeed() const;
+
+private:
+  /**
+   * Time elapsed since the reference according to the steady clock [us]
+   */
+  int64_t getElapsed() const;
+
+  /**
+   * Time of the replay at the reference [us]
+   */
+  uint64_t reference_time;
+
+  /**
+   * Steady clock time stamp at the reference [us]
+   */
+  uint64_t reference_steady_time;
+
+  double speed;
+
+  bool paused;
+};
+
+}  // namespace hl_monitoring
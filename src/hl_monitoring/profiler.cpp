@@ -0,0 +1,249 @@
+#include "hl_monitoring/profiler.h"
+
+#include <hl_communication/utils.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+using namespace hl_communication;
+
+namespace hl_monitoring
+{
+/**
+ * Ratio between the limits of two consecutive buckets
+ */
+static const double bucket_ratio = 1.1;
+
+/**
+ * Durations above 10^8 us (100s) are all stored in the last bucket
+ */
+static const size_t nb_buckets = std::ceil(std::log(1e8) / std::log(bucket_ratio)) + 1;
+
+TimingHistogram::TimingHistogram() : buckets(nb_buckets, 0), count(0), sum(0), max(0)
+{
+}
+
+void TimingHistogram::add(uint64_t duration)
+{
+  buckets[getBucket(duration)]++;
+  count++;
+  sum += duration;
+  max = std::max(max, duration);
+}
+
+void TimingHistogram::merge(const TimingHistogram& other)
+{
+  for (size_t idx = 0; idx < nb_buckets; idx++)
+  {
+    buckets[idx] += other.buckets[idx];
+  }
+  count += other.count;
+  sum += other.sum;
+  max = std::max(max, other.max);
+}
+
+void TimingHistogram::clear()
+{
+  std::fill(buckets.begin(), buckets.end(), 0);
+  count = 0;
+  sum = 0;
+  max = 0;
+}
+
+uint64_t TimingHistogram::getCount() const
+{
+  return count;
+}
+
+double TimingHistogram::getMean() const
+{
+  if (count == 0)
+  {
+    return 0;
+  }
+  return sum / (double)count;
+}
+
+uint64_t TimingHistogram::getMax() const
+{
+  return max;
+}
+
+double TimingHistogram::getPercentile(double percentile) const
+{
+  if (percentile < 0 || percentile > 100)
+  {
+    throw std::out_of_range(HL_DEBUG + " invalid percentile: " + std::to_string(percentile));
+  }
+  if (count == 0)
+  {
+    return 0;
+  }
+  uint64_t rank = std::ceil(percentile / 100 * count);
+  uint64_t nb_samples = 0;
+  for (size_t idx = 0; idx < nb_buckets; idx++)
+  {
+    nb_samples += buckets[idx];
+    if (nb_samples >= rank && nb_samples > 0)
+    {
+      return std::min(getBucketLimit(idx), (double)max);
+    }
+  }
+  return max;
+}
+
+Json::Value TimingHistogram::toJson() const
+{
+  Json::Value v;
+  v["count"] = (Json::UInt64)count;
+  v["mean"] = getMean();
+  v["p50"] = getPercentile(50);
+  v["p95"] = getPercentile(95);
+  v["p99"] = getPercentile(99);
+  v["max"] = (Json::UInt64)max;
+  return v;
+}
+
+size_t TimingHistogram::getBucket(uint64_t duration)
+{
+  if (duration <= 1)
+  {
+    return 0;
+  }
+  size_t bucket = std::ceil(std::log((double)duration) / std::log(bucket_ratio));
+  return std::min(bucket, nb_buckets - 1);
+}
+
+double TimingHistogram::getBucketLimit(size_t bucket)
+{
+  return std::pow(bucket_ratio, bucket);
+}
+
+Profiler::Profiler() : enabled(true)
+{
+}
+
+Profiler& Profiler::getDefault()
+{
+  static Profiler profiler;
+  return profiler;
+}
+
+void Profiler::setEnabled(bool new_enabled)
+{
+  enabled = new_enabled;
+}
+
+bool Profiler::isEnabled() const
+{
+  return enabled;
+}
+
+void Profiler::addTiming(const std::string& stage, uint64_t duration)
+{
+  if (!enabled)
+  {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  timings[stage].add(duration);
+}
+
+void Profiler::increment(const std::string& counter, uint64_t value)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  counters[counter] += value;
+}
+
+void Profiler::setCounter(const std::string& counter, uint64_t value)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  counters[counter] = value;
+}
+
+std::map<std::string, TimingHistogram> Profiler::getTimings() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return timings;
+}
+
+std::map<std::string, uint64_t> Profiler::getCounters() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return counters;
+}
+
+void Profiler::clearTimings()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  timings.clear();
+}
+
+void Profiler::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  timings.clear();
+  counters.clear();
+}
+
+Json::Value Profiler::toJson() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  Json::Value v;
+  v["timings"] = Json::Value(Json::objectValue);
+  for (const auto& entry : timings)
+  {
+    v["timings"][entry.first] = entry.second.toJson();
+  }
+  v["counters"] = Json::Value(Json::objectValue);
+  for (const auto& entry : counters)
+  {
+    v["counters"][entry.first] = (Json::UInt64)entry.second;
+  }
+  return v;
+}
+
+std::string Profiler::getSummary() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(2);
+  oss << std::left << std::setw(40) << "Stage [ms]" << std::right << std::setw(8) << "count" << std::setw(10) << "mean"
+      << std::setw(10) << "p50" << std::setw(10) << "p95" << std::setw(10) << "p99" << std::setw(10) << "max"
+      << std::endl;
+  for (const auto& entry : timings)
+  {
+    const TimingHistogram& h = entry.second;
+    oss << std::left << std::setw(40) << entry.first << std::right << std::setw(8) << h.getCount() << std::setw(10)
+        << h.getMean() / 1000 << std::setw(10) << h.getPercentile(50) / 1000 << std::setw(10)
+        << h.getPercentile(95) / 1000 << std::setw(10) << h.getPercentile(99) / 1000 << std::setw(10)
+        << h.getMax() / 1000.0 << std::endl;
+  }
+  for (const auto& entry : counters)
+  {
+    oss << std::left << std::setw(40) << entry.first << std::right << std::setw(8) << entry.second << std::endl;
+  }
+  return oss.str();
+}
+
+void Profiler::writeFile(const std::string& path) const
+{
+  writeJson(toJson(), path, true);
+}
+
+ScopedTimer::ScopedTimer(const std::string& stage_, Profiler& profiler_)
+  : profiler(profiler_), stage(stage_), start(profiler.isEnabled() ? getTimeStamp() : 0)
+{
+}
+
+ScopedTimer::~ScopedTimer()
+{
+  if (start != 0)
+  {
+    profiler.addTiming(stage, getTimeStamp() - start);
+  }
+}
+
+}  // namespace hl_monitoring
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <json/json.h>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace hl_monitoring
+{
+/**
+ * Distribution of durations stored in buckets growing exponentially, percentiles are approximated with a relative
+ * precision of 10%. Memory used does not depend on the number of samples.
+ */
+class TimingHistogram
+{
+public:
+  TimingHistogram();
+
+  /**
+   * duration: [us]
+   */
+  void add(uint64_t duration);
+
+  /**
+   * Merge the samples of other in this histogram
+   */
+  void merge(const TimingHistogram& other);
+
+  void clear();
+
+  uint64_t getCount() const;
+
+  /**
+   * Average duration [us], 0 if there are no samples
+   */
+  double getMean() const;
+
+  /**
+   * Maximal duration [us]
+   */
+  uint64_t getMax() const;
+
+  /**
+   * Approximation of the given percentile [us], percentile is in [0, 100]
+   */
+  double getPercentile(double percentile) const;
+
+  /**
+   * Summary of the distribution: count, mean, p50, p95, p99 and max
+   */
+  Json::Value toJson() const;
+
+private:
+  static size_t getBucket(uint64_t duration);
+
+  /**
+   * Upper bound of the given bucket [us]
+   */
+  static double getBucketLimit(size_t bucket);
+
+  /**
+   * Number of samples in each bucket
+   */
+  std::vector<uint64_t> buckets;
+
+  uint64_t count;
+  uint64_t sum;
+  uint64_t max;
+};
+
+/**
+ * Collects durations of named stages and named counters, e.g. the number of frames dropped by a provider.
+ *
+ * A default instance is used by the library, it can be exported periodically as a human readable summary or as a json
+ * file. All the methods are thread-safe.
+ */
+class Profiler
+{
+public:
+  Profiler();
+
+  static Profiler& getDefault();
+
+  /**
+   * When disabled, samples are ignored
+   */
+  void setEnabled(bool enabled);
+  bool isEnabled() const;
+
+  /**
+   * duration: [us]
+   */
+  void addTiming(const std::string& stage, uint64_t duration);
+
+  void increment(const std::string& counter, uint64_t value = 1);
+  void setCounter(const std::string& counter, uint64_t value);
+
+  std::map<std::string, TimingHistogram> getTimings() const;
+  std::map<std::string, uint64_t> getCounters() const;
+
+  /**
+   * Remove all timings, counters are kept
+   */
+  void clearTimings();
+  void clear();
+
+  Json::Value toJson() const;
+
+  /**
+   * Human readable table with one line per stage and per counter
+   */
+  std::string getSummary() const;
+
+  /**
+   * Write the content of toJson in the given file
+   */
+  void writeFile(const std::string& path) const;
+
+private:
+  std::atomic<bool> enabled;
+
+  /**
+   * Protects members below
+   */
+  mutable std::mutex mutex;
+
+  std::map<std::string, TimingHistogram> timings;
+
+  std::map<std::string, uint64_t> counters;
+};
+
+/**
+ * Measures the time between its creation and its destruction and adds it to a Profiler
+ */
+class ScopedTimer
+{
+public:
+  ScopedTimer(const std::string& stage, Profiler& profiler = Profiler::getDefault());
+  ~ScopedTimer();
+
+  ScopedTimer(const ScopedTimer& other) = delete;
+  ScopedTimer& operator=(const ScopedTimer& other) = delete;
+
+private:
+  Profiler& profiler;
+
+  std::string stage;
+
+  /**
+   * 0 if the profiler was disabled at creation [us]
+   */
+  uint64_t start;
+};
+
+}  // namespace hl_monitoring
@@ -1,56 +1,120 @@
 #include "hl_monitoring/replay_image_provider.h"
+#include "hl_monitoring/image_provider_factory.h"
+#include "hl_monitoring/meta_information_log.h"
 
 #include <hl_communication/utils.h>
 
-#include <fstream>
+#include <algorithm>
+#include <iostream>
 
 using namespace hl_communication;
 
 namespace hl_monitoring
 {
+static std::unique_ptr<ImageProvider> buildReplayImageProvider(const Json::Value& v,
+                                                               const ImageProviderFactory::BuildContext& context)
+{
+  std::string input_path;
+  checkMember(v, "input_path");
+  readVal(v, "input_path", &input_path);
+  std::unique_ptr<ReplayImageProvider> provider;
+  if (v.isMember("meta_information_path"))
+  {
+    provider.reset(new ReplayImageProvider(input_path, v["meta_information_path"].asString()));
+  }
+  else
+  {
+    provider.reset(new ReplayImageProvider(input_path));
+  }
+  if (v.isMember("cache_size_mb"))
+  {
+    double cache_size_mb;
+    readVal(v, "cache_size_mb", &cache_size_mb);
+    provider->setCacheSize(cache_size_mb);
+  }
+  if (v.isMember("read_ahead"))
+  {
+    int read_ahead;
+    readVal(v, "read_ahead", &read_ahead);
+    provider->setReadAhead(read_ahead);
+  }
+  return provider;
+}
+
+static ImageProviderFactory::Registrar registrar("ReplayImageProvider", buildReplayImageProvider,
+                                                 ImageProviderFactory::Capabilities(false, true, false));
+
+/**
+ * Default memory budget for decoded images [bytes]
+ */
+static const size_t default_cache_size = 256 * 1024 * 1024;
+
+/**
+ * Skipping up to this number of frames by decoding them is considered cheaper than seeking in the video
+ */
+static const int max_frames_skipped = 8;
+
 ReplayImageProvider::ReplayImageProvider()
+  : decoder_index(0)
+  , cache(default_cache_size)
+  , read_ahead(16)
+  , play_direction(1)
+  , requested_index(-1)
+  , requested_direction(1)
+  , request_id(0)
+  , stop_requested(false)
 {
 }
 
-ReplayImageProvider::ReplayImageProvider(const std::string& video_path)
+ReplayImageProvider::ReplayImageProvider(const std::string& video_path) : ReplayImageProvider()
 {
   loadVideo(video_path);
   setDefaultMetaInformation();
+  loadKeyframeIndex(video_path, video_path + ".keyframes.json");
 }
 
 ReplayImageProvider::ReplayImageProvider(const std::string& video_path, const std::string& meta_information_path)
+  : ReplayImageProvider()
 {
   loadVideo(video_path);
   loadMetaInformation(meta_information_path);
+  loadKeyframeIndex(video_path, getKeyframeIndexPath(meta_information_path));
+}
+
+ReplayImageProvider::~ReplayImageProvider()
+{
+  stopReadAhead();
 }
 
 void ReplayImageProvider::loadVideo(const std::string& video_path)
 {
+  stopReadAhead();
+  std::lock_guard<std::mutex> lock(video_mutex);
   if (!video.open(video_path))
   {
     throw std::runtime_error("Failed to open video '" + video_path + "'");
   }
+  cache.clear();
+  keyframe_index.clear();
+  last_img = cv::Mat();
+  decoder_index = 0;
   index = 0;
   nb_frames = video.get(cv::CAP_PROP_FRAME_COUNT);
 }
 
 void ReplayImageProvider::loadMetaInformation(const std::string& meta_information_path)
 {
-  std::ifstream in(meta_information_path, std::ios::binary);
-  if (!in.good())
-  {
-    throw std::runtime_error("Failed to open file '" + meta_information_path + "'");
-  }
-  if (!meta_information.ParseFromIstream(&in))
-  {
-    throw std::runtime_error("Failed to read file '" + meta_information_path + "'");
-  }
+  // Both legacy files and files streamed during live capture are accepted
+  readMetaInformation(meta_information_path, &meta_information);
+  invalidateCameraMetaInformation();
   index = 0;
   nb_frames = meta_information.frames_size();
+  time_stamp_index.clear();
+  time_stamp_index.reserve(nb_frames);
   for (int idx = 0; idx < nb_frames; idx++)
   {
     uint64_t time_stamp = getTS(meta_information.frames(idx), true);
-    if (indices_by_time_stamp.count(time_stamp) > 0)
+    if (time_stamp_index.hasTimeStamp(time_stamp))
     {
       throw std::runtime_error(HL_DEBUG + "Duplicated time_stamp " + std::to_string(time_stamp));
     }
@@ -58,12 +122,42 @@ void ReplayImageProvider::loadMetaInformation(const std::string& meta_informatio
   }
 }
 
+void ReplayImageProvider::loadKeyframeIndex(const std::string& video_path, const std::string& index_path)
+{
+  std::lock_guard<std::mutex> lock(video_mutex);
+  if (!keyframe_index.loadOrBuild(video_path, index_path))
+  {
+    // Not an AVI file or no index inside: seeking is delegated to the backend
+    return;
+  }
+  int video_frames = video.get(cv::CAP_PROP_FRAME_COUNT);
+  if (keyframe_index.getNbFrames() != video_frames)
+  {
+    std::cerr << HL_DEBUG << "ignoring keyframe index of '" << video_path << "': " << keyframe_index.getNbFrames()
+              << " frames indexed while video has " << video_frames << " frames" << std::endl;
+    keyframe_index.clear();
+  }
+}
+
+std::string ReplayImageProvider::getKeyframeIndexPath(const std::string& meta_information_path)
+{
+  std::string prefix = meta_information_path;
+  const std::string extension = ".bin";
+  if (prefix.size() > extension.size() &&
+      prefix.compare(prefix.size() - extension.size(), extension.size(), extension) == 0)
+  {
+    prefix = prefix.substr(0, prefix.size() - extension.size());
+  }
+  return prefix + ".keyframes.json";
+}
+
 void ReplayImageProvider::setDefaultMetaInformation()
 {
   double fps = video.get(cv::CAP_PROP_FPS);
   uint64_t dt = std::pow(10, 6) / fps;
   uint64_t monotonic_ts = 0;
   uint64_t utc_ts = getUTCTimeStamp();  // When setting default meta-information, use current date
+  time_stamp_index.reserve(nb_frames);
   for (int idx = 0; idx < nb_frames; idx++)
   {
     FrameEntry* frame = meta_information.add_frames();
@@ -88,19 +182,18 @@ CalibratedImage ReplayImageProvider::getCalibratedImage(uint64_t time_stamp)
   {
     return CalibratedImage();
   }
-  else if (new_index == index - 1)  // Asking for previous image again
+  else if (new_index == index - 1 && !last_img.empty())  // Asking for previous image again
   {
     img = last_img;
   }
   else
   {
-    if (new_index != index)
-    {
-      setIndex(new_index);
-    }
-    img = getNextImg();
+    play_direction = new_index < index - 1 ? -1 : 1;
+    img = getFrame(new_index);
+    last_img = img;
+    index = new_index + 1;
   }
-  return CalibratedImage(img, getCameraMetaInformation(new_index));
+  return CalibratedImage(img, getSharedCameraMetaInformation(new_index));
 }
 
 cv::Mat ReplayImageProvider::getNextImg()
@@ -109,14 +202,9 @@ cv::Mat ReplayImageProvider::getNextImg()
   {
     throw std::logic_error("Asking for a new frame while stream is finished");
   }
-
-  video >> last_img;
+  play_direction = 1;
+  last_img = getFrame(index);
   index++;
-  if (last_img.empty())
-  {
-    throw std::runtime_error(HL_DEBUG + "Blank frame at frame: " + std::to_string(index) + "/" +
-                             std::to_string(nb_frames));
-  }
   return last_img;
 }
 
@@ -132,10 +220,177 @@ bool ReplayImageProvider::isStreamFinished()
 
 void ReplayImageProvider::setIndex(int new_index)
 {
+  if (new_index < 0 || new_index > nb_frames)
+  {
+    throw std::out_of_range(HL_DEBUG + "Failed to set index to " + std::to_string(new_index) + " in video");
+  }
+  // Seeking in the video is only done when the frame is actually required
   index = new_index;
-  if (!video.set(cv::CAP_PROP_POS_FRAMES, index))
+}
+
+void ReplayImageProvider::setCacheSize(double size_mb)
+{
+  cache.setMaxSize(size_mb * 1024 * 1024);
+}
+
+void ReplayImageProvider::setReadAhead(int nb_frames)
+{
+  // Thread is restarted on next request
+  stopReadAhead();
+  read_ahead = nb_frames;
+}
+
+cv::Mat ReplayImageProvider::getFrame(int frame_index)
+{
+  cv::Mat img;
+  if (!cache.get(frame_index, &img))
+  {
+    std::lock_guard<std::mutex> lock(video_mutex);
+    // The read-ahead thread might have decoded the frame while waiting for the lock
+    if (!cache.get(frame_index, &img))
+    {
+      img = decodeFrame(frame_index);
+    }
+  }
+  requestReadAhead(frame_index);
+  return img;
+}
+
+cv::Mat ReplayImageProvider::decodeFrame(int frame_index)
+{
+  if (frame_index < 0 || frame_index >= nb_frames)
+  {
+    throw std::out_of_range(HL_DEBUG + "invalid frame index: " + std::to_string(frame_index) + "/" +
+                            std::to_string(nb_frames));
+  }
+  bool sequential = decoder_index >= 0 && frame_index >= decoder_index &&
+                    frame_index <= decoder_index + max_frames_skipped;
+  int seek_index = frame_index;
+  if (!sequential && !keyframe_index.empty())
+  {
+    // Decoding has to start from the keyframe anyway: either continue from the current position if it is inside the
+    // same GOP, or seek to the keyframe and cache the whole GOP so that following backward steps are served from memory
+    seek_index = keyframe_index.getKeyframeBefore(frame_index);
+    sequential = decoder_index >= seek_index && decoder_index <= frame_index;
+  }
+  if (!sequential)
+  {
+    if (!video.set(cv::CAP_PROP_POS_FRAMES, seek_index))
+    {
+      decoder_index = -1;  // Position of the decoder is unknown
+      throw std::runtime_error(HL_DEBUG + "Failed to set index to " + std::to_string(seek_index) + " in video");
+    }
+    decoder_index = seek_index;
+  }
+  cv::Mat img;
+  while (decoder_index <= frame_index)
+  {
+    // A new buffer is required for each frame: previous ones might be referenced by the cache
+    img = cv::Mat();
+    video >> img;
+    if (img.empty())
+    {
+      decoder_index = -1;
+      throw std::runtime_error(HL_DEBUG + "Blank frame at frame: " + std::to_string(frame_index) + "/" +
+                               std::to_string(nb_frames));
+    }
+    cache.insert(decoder_index, img);
+    decoder_index++;
+  }
+  return img;
+}
+
+void ReplayImageProvider::requestReadAhead(int frame_index)
+{
+  if (read_ahead <= 0 || cache.getMaxSize() == 0)
+  {
+    return;
+  }
+  if (!read_ahead_thread.joinable())
+  {
+    startReadAhead();
+  }
+  {
+    std::lock_guard<std::mutex> lock(request_mutex);
+    requested_index = frame_index;
+    requested_direction = play_direction;
+    request_id++;
+  }
+  request_received.notify_one();
+}
+
+void ReplayImageProvider::startReadAhead()
+{
+  stop_requested = false;
+  read_ahead_thread = std::thread(&ReplayImageProvider::runReadAhead, this);
+}
+
+void ReplayImageProvider::stopReadAhead()
+{
+  if (!read_ahead_thread.joinable())
+  {
+    return;
+  }
   {
-    throw std::runtime_error(HL_DEBUG + "Failed to set index to " + std::to_string(index) + " in video");
+    std::lock_guard<std::mutex> lock(request_mutex);
+    stop_requested = true;
   }
+  request_received.notify_all();
+  read_ahead_thread.join();
 }
+
+void ReplayImageProvider::runReadAhead()
+{
+  uint64_t handled_id = 0;
+  while (true)
+  {
+    int target, direction;
+    uint64_t current_id;
+    {
+      std::unique_lock<std::mutex> lock(request_mutex);
+      request_received.wait(lock, [&]() { return stop_requested || request_id != handled_id; });
+      if (stop_requested)
+      {
+        return;
+      }
+      target = requested_index;
+      direction = requested_direction;
+      current_id = request_id;
+      handled_id = current_id;
+    }
+    // Frames are always decoded in increasing order to avoid seeking for each frame
+    int start = target + 1;
+    int end = std::min(nb_frames - 1, target + read_ahead);
+    if (direction < 0)
+    {
+      start = std::max(0, target - read_ahead);
+      end = target - 1;
+    }
+    for (int frame_index = start; frame_index <= end; frame_index++)
+    {
+      {
+        std::lock_guard<std::mutex> lock(request_mutex);
+        if (stop_requested || request_id != current_id)
+        {
+          break;
+        }
+      }
+      if (cache.contains(frame_index))
+      {
+        continue;
+      }
+      std::lock_guard<std::mutex> lock(video_mutex);
+      try
+      {
+        decodeFrame(frame_index);
+      }
+      catch (const std::exception&)
+      {
+        // Errors are reported when the frame is explicitly requested
+        break;
+      }
+    }
+  }
+}
+
 }  // namespace hl_monitoring
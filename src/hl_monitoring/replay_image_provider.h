@@ -1,17 +1,34 @@
 #pragma once
 
+#include "hl_monitoring/frame_cache.h"
 #include "hl_monitoring/image_provider.h"
+#include "hl_monitoring/keyframe_index.h"
 
 #include <opencv2/videoio.hpp>
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 namespace hl_monitoring
 {
+/**
+ * Provides images from a video file.
+ *
+ * Decoded images are stored in a FrameCache, and a background thread decodes the frames which are likely to be
+ * requested next, depending on the current playing direction. Therefore, stepping, scrubbing and backward playback are
+ * mostly served from memory instead of seeking in the video.
+ *
+ * For AVI files, a keyframe index is built on first opening and saved next to the meta information, seeking is then
+ * always done to a keyframe and the whole group of pictures is decoded once.
+ */
 class ReplayImageProvider : public ImageProvider
 {
 public:
   ReplayImageProvider();
   ReplayImageProvider(const std::string& video_path);
   ReplayImageProvider(const std::string& video_path, const std::string& meta_information_path);
+  virtual ~ReplayImageProvider();
 
   void loadVideo(const std::string& video_path);
   /**
@@ -19,6 +36,16 @@ public:
    */
   void setDefaultMetaInformation();
   void loadMetaInformation(const std::string& meta_information_path);
+  /**
+   * Load the keyframe index from index_path or build it from the video, the index is ignored if it does not match the
+   * video
+   */
+  void loadKeyframeIndex(const std::string& video_path, const std::string& index_path);
+
+  /**
+   * Return the default path of the keyframe index associated to the given meta information file
+   */
+  static std::string getKeyframeIndexPath(const std::string& meta_information_path);
 
   void restartStream() override;
 
@@ -32,16 +59,98 @@ public:
 
   void setIndex(int index);
 
+  /**
+   * Set the memory budget for decoded images [MB], 0 disables the cache
+   */
+  void setCacheSize(double size_mb);
+
+  /**
+   * Set the number of frames decoded in advance in the current playing direction, 0 disables read-ahead
+   */
+  void setReadAhead(int nb_frames);
+
 private:
   /**
-   * The video read from the file
+   * Return the image at the given index, from the cache if possible
+   */
+  cv::Mat getFrame(int frame_index);
+
+  /**
+   * Decode the image at the given index and insert it in the cache, seeking in the video only if required.
+   * video_mutex has to be locked.
+   */
+  cv::Mat decodeFrame(int frame_index);
+
+  /**
+   * Inform the read-ahead thread of the last frame requested
+   */
+  void requestReadAhead(int frame_index);
+
+  void startReadAhead();
+  void stopReadAhead();
+
+  /**
+   * Main loop of the read-ahead thread
+   */
+  void runReadAhead();
+
+  /**
+   * The video read from the file, access is protected by video_mutex
    */
   cv::VideoCapture video;
 
+  /**
+   * Index of the next frame returned by reading 'video'
+   */
+  int decoder_index;
+
+  /**
+   * Position of the keyframes in the video, empty if the container is not supported
+   */
+  KeyframeIndex keyframe_index;
+
+  std::mutex video_mutex;
+
   /**
    * The last image retrieved
    */
   cv::Mat last_img;
+
+  /**
+   * Decoded images
+   */
+  FrameCache cache;
+
+  /**
+   * Number of frames decoded in advance
+   */
+  int read_ahead;
+
+  /**
+   * Direction of the last move: 1 -> forward, -1 -> backward
+   */
+  int play_direction;
+
+  std::thread read_ahead_thread;
+
+  /**
+   * Protects members below, used to communicate with the read-ahead thread
+   */
+  std::mutex request_mutex;
+  std::condition_variable request_received;
+
+  /**
+   * The last index requested and the direction at this moment
+   */
+  int requested_index;
+  int requested_direction;
+
+  /**
+   * Incremented on each request, allows the read-ahead thread to abandon outdated work
+   */
+  uint64_t request_id;
+
+  bool stop_requested;
 };
 
 }  // namespace hl_monitoring
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace hl_monitoring
+{
+/**
+ * A bounded lock-free queue for exactly one producer thread and one consumer thread.
+ *
+ * - push() must only be called from the producer thread
+ * - pop() must only be called from the consumer thread
+ *
+ * When the buffer is full, push() refuses the new element and returns false, it is up to the producer to decide what
+ * to do with it (typically counting it as a dropped element).
+ */
+template <typename T>
+class SPSCRingBuffer
+{
+public:
+  /**
+   * capacity: maximal number of elements stored simultaneously in the buffer
+   */
+  SPSCRingBuffer(size_t capacity) : slots(capacity + 1), head(0), tail(0)
+  {
+  }
+
+  SPSCRingBuffer(const SPSCRingBuffer& other) = delete;
+  SPSCRingBuffer& operator=(const SPSCRingBuffer& other) = delete;
+
+  /**
+   * Moves 'element' at the end of the queue, returns false if the queue is full. In this case, element is left
+   * untouched.
+   */
+  bool push(T&& element)
+  {
+    size_t current_tail = tail.load(std::memory_order_relaxed);
+    size_t next_tail = increment(current_tail);
+    if (next_tail == head.load(std::memory_order_acquire))
+    {
+      return false;
+    }
+    slots[current_tail] = std::move(element);
+    tail.store(next_tail, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Moves the oldest element of the queue in 'element', returns false if the queue is empty
+   */
+  bool pop(T* element)
+  {
+    size_t current_head = head.load(std::memory_order_relaxed);
+    if (current_head == tail.load(std::memory_order_acquire))
+    {
+      return false;
+    }
+    *element = std::move(slots[current_head]);
+    // Release resources held by the slot as soon as possible (e.g. image buffers)
+    slots[current_head] = T();
+    head.store(increment(current_head), std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Approximative number of elements in the queue, exact if called when neither the producer nor the consumer are
+   * active
+   */
+  size_t size() const
+  {
+    size_t current_head = head.load(std::memory_order_acquire);
+    size_t current_tail = tail.load(std::memory_order_acquire);
+    if (current_tail >= current_head)
+    {
+      return current_tail - current_head;
+    }
+    return slots.size() - current_head + current_tail;
+  }
+
+  size_t capacity() const
+  {
+    return slots.size() - 1;
+  }
+
+private:
+  size_t increment(size_t idx) const
+  {
+    idx++;
+    return idx == slots.size() ? 0 : idx;
+  }
+
+  /**
+   * Storage for the elements, one slot is always left empty to distinguish a full buffer from an empty one
+   */
+  std::vector<T> slots;
+
+  /**
+   * Index of the oldest element, only written by the consumer.
+   * head and tail are kept on separate cache lines to avoid false sharing between both threads
+   */
+  alignas(64) std::atomic<size_t> head;
+
+  /**
+   * Index of the slot where the next element will be written, only written by the producer
+   */
+  alignas(64) std::atomic<size_t> tail;
+};
+
+}  // namespace hl_monitoring
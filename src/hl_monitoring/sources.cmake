@@ -1,15 +1,32 @@
 set(SOURCES
   calibrated_image.cpp
+  capture_thread.cpp
   field.cpp
+  field_lines_projection.cpp
+  frame_cache.cpp
   top_view_drawer.cpp
+  image_buffer_pool.cpp
   image_provider.cpp
+  image_provider_factory.cpp
+  jpeg_chunk_log.cpp
+  jpeg_chunk_replay_image_provider.cpp
+  keyframe_index.cpp
   manual_pose_solver.cpp
+  message_log.cpp
+  meta_information_log.cpp
   monitoring_manager.cpp
   opencv_image_provider.cpp
+  playback_clock.cpp
+  profiler.cpp
   replay_image_provider.cpp
   replay_viewer.cpp
+  synthetic_image_provider.cpp
   team_config.cpp
   team_manager.cpp
+  thread_pool.cpp
+  time_stamp_index.cpp
+  undistorter.cpp
+  video_writer_stage.cpp
   )
 
 if (HL_MONITORING_USES_FLYCAPTURE)
@@ -17,3 +34,9 @@ if (HL_MONITORING_USES_FLYCAPTURE)
     flycap_image_provider.cpp
   )
 endif(HL_MONITORING_USES_FLYCAPTURE)
+
+if (HL_MONITORING_USES_LIBAV)
+  set(SOURCES "${SOURCES}"
+    libav_replay_image_provider.cpp
+  )
+endif(HL_MONITORING_USES_LIBAV)
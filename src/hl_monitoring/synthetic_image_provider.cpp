@@ -0,0 +1,287 @@
+#include "hl_monitoring/synthetic_image_provider.h"
+#include "hl_monitoring/image_provider_factory.h"
+#include "hl_monitoring/meta_information_log.h"
+
+#include <hl_communication/utils.h>
+#include <hl_monitoring/profiler.h>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+using namespace hl_communication;
+
+namespace hl_monitoring
+{
+static std::unique_ptr<ImageProvider> buildSyntheticImageProvider(const Json::Value& v,
+                                                                  const ImageProviderFactory::BuildContext& context)
+{
+  if (context.field == nullptr)
+  {
+    throw std::logic_error(HL_DEBUG + " a field is required to build a SyntheticImageProvider");
+  }
+  return std::unique_ptr<ImageProvider>(new SyntheticImageProvider(v, *context.field, context.output_prefix));
+}
+
+/**
+ * Past frames are rendered again on request, the provider is therefore seekable even if it is live
+ */
+static ImageProviderFactory::Registrar registrar("SyntheticImageProvider", buildSyntheticImageProvider,
+                                                 ImageProviderFactory::Capabilities(true, true, false));
+
+SyntheticImageProvider::SyntheticImageProvider(const Json::Value& v, const Field& field_,
+                                               const std::string& output_prefix_)
+  : field(field_)
+  , fps(30)
+  , jitter(0)
+  , drop_rate(0)
+  , max_frames(0)
+  , start_ts(0)
+  , utc_offset(0)
+  , nb_scheduled(0)
+  , next_frame_ts(0)
+  , nb_dropped(0)
+  , default_img_size(640, 480)
+  , background_field_version(0)
+  , output_prefix(output_prefix_)
+{
+  double jitter_ms = 0;
+  int seed = 0;
+  int nb_max_frames = 0;
+  tryReadVal(v, "width", &default_img_size.width);
+  tryReadVal(v, "height", &default_img_size.height);
+  tryReadVal(v, "fps", &fps);
+  tryReadVal(v, "jitter_ms", &jitter_ms);
+  tryReadVal(v, "drop_rate", &drop_rate);
+  tryReadVal(v, "seed", &seed);
+  tryReadVal(v, "max_frames", &nb_max_frames);
+  if (default_img_size.width <= 0 || default_img_size.height <= 0)
+  {
+    std::ostringstream oss;
+    oss << HL_DEBUG << " invalid image size " << default_img_size;
+    throw std::runtime_error(oss.str());
+  }
+  if (fps <= 0)
+  {
+    throw std::runtime_error(HL_DEBUG + " invalid fps: " + std::to_string(fps));
+  }
+  if (jitter_ms < 0 || drop_rate < 0 || drop_rate >= 1 || nb_max_frames < 0)
+  {
+    throw std::runtime_error(HL_DEBUG + " invalid jitter_ms, drop_rate or max_frames");
+  }
+  jitter = jitter_ms * 1000;
+  max_frames = nb_max_frames;
+  engine.seed(seed);
+  if (v.isMember("writer"))
+  {
+    output.fromJson(v["writer"]);
+  }
+}
+
+SyntheticImageProvider::~SyntheticImageProvider()
+{
+  saveVideoMetaInformation();
+  output.close();
+}
+
+double SyntheticImageProvider::getFPS() const
+{
+  return fps;
+}
+
+uint64_t SyntheticImageProvider::getNbDroppedFrames() const
+{
+  return nb_dropped + output.getStatistics().nb_dropped;
+}
+
+VideoWriterStage& SyntheticImageProvider::getVideoWriter()
+{
+  return output;
+}
+
+std::string SyntheticImageProvider::getOutputVideoPath() const
+{
+  if (output_prefix == "")
+  {
+    return "";
+  }
+  return output.getVideoPath(output_prefix);
+}
+
+void SyntheticImageProvider::restartStream()
+{
+  throw std::logic_error("It makes no sense to restart the stream in a 'SyntheticImageProvider'");
+}
+
+CalibratedImage SyntheticImageProvider::getCalibratedImage(uint64_t time_stamp)
+{
+  if (nb_frames == 0)
+  {
+    throw std::runtime_error(HL_DEBUG + " no frames found in the stream");
+  }
+  int frame_index = getIndex(time_stamp);
+  if (frame_index < 0)
+  {
+    throw std::runtime_error(HL_DEBUG + " no frame available before " + std::to_string(time_stamp));
+  }
+  if (frame_index == index)
+  {
+    return CalibratedImage(img, getSharedCameraMetaInformation(index));
+  }
+  return CalibratedImage(renderFrame(frame_index), getSharedCameraMetaInformation(frame_index));
+}
+
+void SyntheticImageProvider::update()
+{
+  startStream();
+  uint64_t now = getTimeStamp();
+  while (!isStreamFinished() && next_frame_ts <= now)
+  {
+    produceFrame();
+  }
+}
+
+cv::Mat SyntheticImageProvider::getNextImg()
+{
+  startStream();
+  while (!isStreamFinished())
+  {
+    uint64_t now = getTimeStamp();
+    if (next_frame_ts > now)
+    {
+      std::this_thread::sleep_for(std::chrono::microseconds(next_frame_ts - now));
+    }
+    if (produceFrame())
+    {
+      return img;
+    }
+  }
+  throw std::runtime_error(HL_DEBUG + " end of stream reached");
+}
+
+bool SyntheticImageProvider::isStreamFinished()
+{
+  return max_frames > 0 && nb_scheduled >= max_frames;
+}
+
+void SyntheticImageProvider::saveVideoMetaInformation()
+{
+  // Do not save if no output_prefix has been provided
+  if (output_prefix == "")
+    return;
+  output.writeHeader(extractHeader(&meta_information));
+}
+
+void SyntheticImageProvider::onHeaderChange()
+{
+  if (!img.empty() && img.size() != getImgSize())
+  {
+    throw std::runtime_error(HL_DEBUG + " size of the images cannot change once the stream has started");
+  }
+  saveVideoMetaInformation();
+}
+
+void SyntheticImageProvider::onFrameChange(const FrameEntry& entry)
+{
+  // Entry has already been pushed to the writer, the update is applied when reading the meta information
+  output.writeFrameUpdate(entry);
+}
+
+cv::Size SyntheticImageProvider::getImgSize() const
+{
+  if (meta_information.has_camera_parameters())
+  {
+    const IntrinsicParameters& camera_parameters = meta_information.camera_parameters();
+    return cv::Size(camera_parameters.img_width(), camera_parameters.img_height());
+  }
+  return default_img_size;
+}
+
+cv::Mat SyntheticImageProvider::renderFrame(int frame_index) const
+{
+  ScopedTimer timer("SyntheticImageProvider::renderFrame");
+  std::shared_ptr<const CameraMetaInformation> camera_meta = getSharedCameraMetaInformation(frame_index);
+  cv::Size img_size = getImgSize();
+  uint64_t field_version = field.getVersion();
+  if (background.empty() || camera_meta != background_meta || background.size() != img_size ||
+      field_version != background_field_version)
+  {
+    background = cv::Mat(img_size, CV_8UC3, cv::Scalar(0, 120, 0));
+    if (camera_meta && camera_meta->has_camera_parameters() && camera_meta->has_pose())
+    {
+      lines_projection.tagLines(field, CalibratedImage(background, camera_meta), &background,
+                                cv::Scalar(255, 255, 255), 2, 10);
+    }
+    background_meta = camera_meta;
+    background_field_version = field_version;
+  }
+  // Moving content ensures that the encoder does not process a static stream
+  cv::Mat frame = background.clone();
+  int x = (frame_index * 7) % img_size.width;
+  cv::circle(frame, cv::Point(x, img_size.height / 2), 15, cv::Scalar(255, 255, 255), cv::FILLED);
+  cv::putText(frame, std::to_string(frame_index), cv::Point(20, 50), cv::FONT_HERSHEY_SIMPLEX, 1.5,
+              cv::Scalar(0, 0, 0), 3);
+  return frame;
+}
+
+void SyntheticImageProvider::startStream()
+{
+  if (start_ts != 0)
+  {
+    return;
+  }
+  start_ts = getTimeStamp();
+  utc_offset = (int64_t)getUTCTimeStamp() - (int64_t)start_ts;
+  scheduleNextFrame();
+}
+
+void SyntheticImageProvider::scheduleNextFrame()
+{
+  double period = 1000 * 1000 / fps;
+  double delay = 0;
+  if (jitter > 0)
+  {
+    // Bounding the delay ensures that frames stay ordered
+    double max_delay = 0.45 * period;
+    std::normal_distribution<double> delay_distribution(0, jitter);
+    delay = std::max(-max_delay, std::min(max_delay, delay_distribution(engine)));
+  }
+  // Frames are expected in the middle of their period, so that the delay never places them before start_ts
+  next_frame_ts = start_ts + (uint64_t)((nb_scheduled + 0.5) * period + delay);
+}
+
+bool SyntheticImageProvider::produceFrame()
+{
+  std::uniform_real_distribution<double> drop_distribution(0, 1);
+  bool dropped = drop_distribution(engine) < drop_rate;
+  uint64_t frame_ts = next_frame_ts;
+  nb_scheduled++;
+  scheduleNextFrame();
+  if (dropped)
+  {
+    nb_dropped++;
+    return false;
+  }
+  index = nb_frames;
+  pushTimeStamp(index, frame_ts);
+  FrameEntry* entry = meta_information.add_frames();
+  entry->set_utc_ts(frame_ts + utc_offset);
+  entry->set_monotonic_ts(frame_ts);
+  nb_frames++;
+  img = renderFrame(index);
+  if (output_prefix != "")
+  {
+    if (!output.isOpened())
+    {
+      output.open(getOutputVideoPath(), output.getFourcc(), fps, img.size(), true);
+      output.openMetaInformation(output_prefix + ".bin", extractHeader(&meta_information));
+    }
+    output.push(img, *entry);
+  }
+  return true;
+}
+
+}  // namespace hl_monitoring
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "hl_monitoring/field.h"
+#include "hl_monitoring/field_lines_projection.h"
+#include "hl_monitoring/image_provider.h"
+#include "hl_monitoring/video_writer_stage.h"
+
+#include <json/json.h>
+
+#include <random>
+
+namespace hl_monitoring
+{
+/**
+ * A live stream rendering the field seen by a virtual camera, allows to test the live path without any hardware.
+ *
+ * - The field is drawn according to the intrinsic parameters and default pose of the provider, if one of them is
+ *   missing, only the turf is drawn
+ * - Frames are scheduled at a fixed frequency with a random jitter, some of them can be dropped randomly. The random
+ *   generator is seeded from the parameters, so that a scenario can be reproduced exactly.
+ * - Images read can be directly encoded in a video, as for OpenCVImageProvider
+ *
+ * Parameters (all optional):
+ * - width, height: size of the images [px], ignored if intrinsic parameters are provided (default 640*480)
+ * - fps: frequency of the frames [Hz] (default 30)
+ * - jitter_ms: standard deviation of the delay between the expected and the actual time of a frame [ms], bounded by
+ *   half of the period (default 0)
+ * - drop_rate: probability of a frame being dropped by the virtual camera (default 0)
+ * - seed: seed of the random generator (default 0)
+ * - max_frames: number of frames scheduled before the stream is finished, 0 for an infinite stream (default 0)
+ * - writer: configuration of the VideoWriterStage
+ */
+class SyntheticImageProvider : public ImageProvider
+{
+public:
+  /**
+   * If output_prefix is not empty, write video and MetaInformation during execution. 'field' has to outlive the
+   * provider, modifications of its dimensions are taken into account for the next frames rendered.
+   */
+  SyntheticImageProvider(const Json::Value& parameters, const Field& field, const std::string& output_prefix = "");
+  virtual ~SyntheticImageProvider();
+
+  double getFPS() const;
+
+  /**
+   * Number of frames dropped by the virtual camera, plus the number of images dropped by the video writer
+   */
+  uint64_t getNbDroppedFrames() const override;
+
+  /**
+   * Access to the stage encoding the output video, allows to configure its queue
+   */
+  VideoWriterStage& getVideoWriter();
+
+  std::string getOutputVideoPath() const override;
+
+  void restartStream() override;
+
+  /**
+   * Since frames are synthetic, images of past frames are rendered again on request
+   */
+  CalibratedImage getCalibratedImage(uint64_t time_stamp) override;
+
+  /**
+   * Register all the frames scheduled before now, never blocks
+   */
+  void update() override;
+
+  /**
+   * Wait until the next frame which is not dropped and return it
+   */
+  cv::Mat getNextImg() override;
+
+  bool isStreamFinished() override;
+
+  /**
+   * Write the information shared by all the frames to the meta information file, frames are written as soon as they
+   * are encoded
+   */
+  void saveVideoMetaInformation();
+
+protected:
+  void onHeaderChange() override;
+  void onFrameChange(const hl_communication::FrameEntry& entry) override;
+
+private:
+  /**
+   * Size of the images produced, based on camera parameters if available
+   */
+  cv::Size getImgSize() const;
+
+  /**
+   * Draw the frame with the given index
+   */
+  cv::Mat renderFrame(int frame_index) const;
+
+  /**
+   * Schedule the first frame if the stream has not started yet
+   */
+  void startStream();
+
+  /**
+   * Set next_frame_ts according to the schedule of the frame number nb_scheduled
+   */
+  void scheduleNextFrame();
+
+  /**
+   * Handle the frame scheduled at next_frame_ts, returns false if the frame has been dropped
+   */
+  bool produceFrame();
+
+  /**
+   * Owned by the manager, a copy would not follow the dimensions tuned over RhIO
+   */
+  const Field& field;
+
+  double fps;
+  double jitter;
+  double drop_rate;
+  uint64_t max_frames;
+
+  std::mt19937 engine;
+
+  /**
+   * Time at which the first frame is scheduled, 0 until the stream starts [us] (steady clock)
+   */
+  uint64_t start_ts;
+
+  /**
+   * Offset between utc and steady clock when the stream started [us]
+   */
+  int64_t utc_offset;
+
+  /**
+   * Number of frames scheduled, including the dropped ones
+   */
+  uint64_t nb_scheduled;
+
+  /**
+   * Time at which the next frame is expected [us] (steady clock)
+   */
+  uint64_t next_frame_ts;
+
+  /**
+   * Number of frames dropped by the virtual camera
+   */
+  uint64_t nb_dropped;
+
+  /**
+   * Last img produced
+   */
+  cv::Mat img;
+
+  /**
+   * Size of the images when camera parameters are not set
+   */
+  cv::Size default_img_size;
+
+  /**
+   * Image of the field without moving elements and the meta information used to render it
+   */
+  mutable cv::Mat background;
+  mutable std::shared_ptr<const hl_communication::CameraMetaInformation> background_meta;
+  mutable uint64_t background_field_version;
+  mutable FieldLinesProjection lines_projection;
+
+  /**
+   * Encodes the images produced in a video, opened with the first frame
+   */
+  VideoWriterStage output;
+
+  /**
+   * The prefix used for writing video file and meta_information file. If empty, then no files are written
+   */
+  std::string output_prefix;
+};
+
+}  // namespace hl_monitoring
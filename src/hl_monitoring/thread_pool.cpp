@@ -0,0 +1,57 @@
+#include "hl_monitoring/thread_pool.h"
+
+#include <algorithm>
+
+namespace hl_monitoring
+{
+ThreadPool::ThreadPool(size_t nb_threads) : stop_requested(false)
+{
+  if (nb_threads == 0)
+  {
+    nb_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (size_t idx = 0; idx < nb_threads; idx++)
+  {
+    workers.push_back(std::thread(&ThreadPool::run, this));
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop_requested = true;
+  }
+  task_available.notify_all();
+  for (std::thread& worker : workers)
+  {
+    worker.join();
+  }
+}
+
+size_t ThreadPool::getNbThreads() const
+{
+  return workers.size();
+}
+
+void ThreadPool::run()
+{
+  while (true)
+  {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      task_available.wait(lock, [this]() { return stop_requested || !tasks.empty(); });
+      if (tasks.empty())
+      {
+        return;
+      }
+      task = std::move(tasks.front());
+      tasks.pop();
+    }
+    // Exceptions are stored in the future by packaged_task
+    task();
+  }
+}
+
+}  // namespace hl_monitoring
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace hl_monitoring
+{
+/**
+ * A fixed set of worker threads executing tasks in the order they were submitted.
+ *
+ * Results and exceptions of the tasks are retrieved through the std::future returned by submit. Tasks still pending
+ * when the pool is destroyed are executed before the workers are joined.
+ */
+class ThreadPool
+{
+public:
+  /**
+   * nb_threads: number of workers, if 0, uses the number of hardware threads
+   */
+  ThreadPool(size_t nb_threads = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool& other) = delete;
+  ThreadPool& operator=(const ThreadPool& other) = delete;
+
+  size_t getNbThreads() const;
+
+  /**
+   * Queue the task for execution by one of the workers
+   */
+  template <typename F>
+  std::future<typename std::result_of<F()>::type> submit(F&& task)
+  {
+    typedef typename std::result_of<F()>::type Result;
+    // std::function requires copyable objects, packaged_task is therefore shared
+    auto packaged_task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+    std::future<Result> result = packaged_task->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (stop_requested)
+      {
+        throw std::logic_error("ThreadPool::submit: pool is stopping");
+      }
+      tasks.push([packaged_task]() { (*packaged_task)(); });
+    }
+    task_available.notify_one();
+    return result;
+  }
+
+private:
+  /**
+   * Main loop of the workers
+   */
+  void run();
+
+  std::vector<std::thread> workers;
+
+  /**
+   * Protects the members below
+   */
+  std::mutex mutex;
+  std::condition_variable task_available;
+
+  std::queue<std::function<void()>> tasks;
+
+  bool stop_requested;
+};
+
+}  // namespace hl_monitoring
@@ -0,0 +1,190 @@
+#include "hl_monitoring/time_stamp_index.h"
+
+#include <hl_communication/utils.h>
+
+#include <algorithm>
+
+namespace hl_monitoring
+{
+TimeStampIndex::TimeStampIndex() : first_index(0), monotonic(true)
+{
+}
+
+void TimeStampIndex::push(int index, uint64_t time_stamp)
+{
+  int expected_index = first_index + (int)time_stamps.size();
+  if (index != expected_index)
+  {
+    throw std::logic_error(HL_DEBUG + " invalid index " + std::to_string(index) + ", expecting " +
+                           std::to_string(expected_index));
+  }
+  if (monotonic && !time_stamps.empty() && time_stamp <= time_stamps.back())
+  {
+    // Switching to fallback mode: build the sorted entries from scratch
+    monotonic = false;
+    sorted_entries.reserve(time_stamps.capacity());
+    for (size_t idx = 0; idx < time_stamps.size(); idx++)
+    {
+      sorted_entries.push_back({ time_stamps[idx], first_index + (int)idx });
+    }
+  }
+  time_stamps.push_back(time_stamp);
+  if (!monotonic)
+  {
+    auto it = std::lower_bound(sorted_entries.begin(), sorted_entries.end(), Entry(time_stamp, 0),
+                               [](const Entry& a, const Entry& b) { return a.first < b.first; });
+    if (it != sorted_entries.end() && it->first == time_stamp)
+    {
+      it->second = index;
+    }
+    else
+    {
+      sorted_entries.insert(it, { time_stamp, index });
+    }
+  }
+}
+
+void TimeStampIndex::clear()
+{
+  time_stamps.clear();
+  sorted_entries.clear();
+  first_index = 0;
+  monotonic = true;
+}
+
+void TimeStampIndex::eraseBefore(int index)
+{
+  int nb_erased = std::min(index - first_index, (int)time_stamps.size());
+  if (nb_erased <= 0)
+  {
+    return;
+  }
+  time_stamps.erase(time_stamps.begin(), time_stamps.begin() + nb_erased);
+  first_index += nb_erased;
+  if (!monotonic)
+  {
+    sorted_entries.erase(std::remove_if(sorted_entries.begin(), sorted_entries.end(),
+                                        [this](const Entry& e) { return e.second < first_index; }),
+                         sorted_entries.end());
+  }
+}
+
+int TimeStampIndex::getFirstIndex() const
+{
+  return first_index;
+}
+
+void TimeStampIndex::reserve(size_t nb_entries)
+{
+  time_stamps.reserve(nb_entries);
+}
+
+size_t TimeStampIndex::size() const
+{
+  return time_stamps.size();
+}
+
+bool TimeStampIndex::empty() const
+{
+  return time_stamps.empty();
+}
+
+bool TimeStampIndex::isMonotonic() const
+{
+  return monotonic;
+}
+
+uint64_t TimeStampIndex::getTimeStamp(int index) const
+{
+  if (index < first_index || index >= first_index + (int)time_stamps.size())
+  {
+    throw std::out_of_range(HL_DEBUG + " invalid index: " + std::to_string(index));
+  }
+  return time_stamps[index - first_index];
+}
+
+int TimeStampIndex::getIndex(uint64_t time_stamp) const
+{
+  if (monotonic)
+  {
+    return getMonotonicIndex(time_stamp);
+  }
+  return getSortedIndex(time_stamp);
+}
+
+bool TimeStampIndex::hasTimeStamp(uint64_t time_stamp) const
+{
+  int index = getIndex(time_stamp);
+  if (index < 0)
+  {
+    return false;
+  }
+  return getTimeStamp(index) == time_stamp;
+}
+
+uint64_t TimeStampIndex::getStart() const
+{
+  if (time_stamps.empty())
+  {
+    throw std::out_of_range(HL_DEBUG + " no entries");
+  }
+  return monotonic ? time_stamps.front() : sorted_entries.front().first;
+}
+
+uint64_t TimeStampIndex::getEnd() const
+{
+  if (time_stamps.empty())
+  {
+    throw std::out_of_range(HL_DEBUG + " no entries");
+  }
+  return monotonic ? time_stamps.back() : sorted_entries.back().first;
+}
+
+int TimeStampIndex::getMonotonicIndex(uint64_t time_stamp) const
+{
+  if (time_stamps.empty() || time_stamp < time_stamps.front())
+  {
+    return -1;
+  }
+  int last = time_stamps.size() - 1;
+  if (time_stamp >= time_stamps[last])
+  {
+    return first_index + last;
+  }
+  // Frames are received at an almost constant rate: interpolation provides a very accurate guess
+  uint64_t start = time_stamps.front();
+  uint64_t end = time_stamps[last];
+  int guess = (int)((double)(time_stamp - start) / (end - start) * last);
+  guess = std::max(0, std::min(last - 1, guess));
+  if (time_stamps[guess] <= time_stamp && time_stamp < time_stamps[guess + 1])
+  {
+    return first_index + guess;
+  }
+  // Narrow the range using the guess, then use a binary search
+  auto begin = time_stamps.begin();
+  auto end_it = time_stamps.end();
+  if (time_stamps[guess] <= time_stamp)
+  {
+    begin += guess + 1;
+  }
+  else
+  {
+    end_it = begin + guess;
+  }
+  auto it = std::upper_bound(begin, end_it, time_stamp);
+  return first_index + (int)(it - time_stamps.begin()) - 1;
+}
+
+int TimeStampIndex::getSortedIndex(uint64_t time_stamp) const
+{
+  auto it = std::upper_bound(sorted_entries.begin(), sorted_entries.end(), time_stamp,
+                             [](uint64_t ts, const Entry& e) { return ts < e.first; });
+  if (it == sorted_entries.begin())
+  {
+    return -1;
+  }
+  it--;
+  return it->second;
+}
+
+}  // namespace hl_monitoring
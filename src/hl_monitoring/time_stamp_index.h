@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace hl_monitoring
+{
+/**
+ * Associates frame indices to time_stamps using contiguous storage.
+ *
+ * Entries are appended with consecutive indices starting at 0. As long as time_stamps are strictly increasing (which is
+ * the case for live streams by construction), a single vector is used and lookups use an interpolation search followed
+ * by a binary search. If an out-of-order time_stamp is inserted, a sorted copy of the entries is maintained and used
+ * for lookups.
+ *
+ * The oldest entries can be discarded to bound memory usage, indices of the remaining entries are not modified.
+ */
+class TimeStampIndex
+{
+public:
+  TimeStampIndex();
+
+  /**
+   * Append an entry, 'index' has to be equal to the index following the last entry.
+   * If 'time_stamp' is already present, the new index replaces the previous one for time_stamp based lookups.
+   */
+  void push(int index, uint64_t time_stamp);
+
+  void clear();
+
+  /**
+   * Discard all the entries with an index strictly lower than 'index'
+   */
+  void eraseBefore(int index);
+
+  /**
+   * Index of the oldest entry kept
+   */
+  int getFirstIndex() const;
+
+  /**
+   * Reserve memory for the given number of entries
+   */
+  void reserve(size_t nb_entries);
+
+  /**
+   * Number of entries kept
+   */
+  size_t size() const;
+  bool empty() const;
+
+  /**
+   * Return true if time_stamps have been pushed in strictly increasing order
+   */
+  bool isMonotonic() const;
+
+  /**
+   * Return the time_stamp associated to the given index, throws std::out_of_range on invalid index
+   */
+  uint64_t getTimeStamp(int index) const;
+
+  /**
+   * Return the index of the last entry with a time_stamp lower or equal to the given time_stamp, if there are no such
+   * entry, returns -1
+   */
+  int getIndex(uint64_t time_stamp) const;
+
+  /**
+   * Return true if an entry has exactly the given time_stamp
+   */
+  bool hasTimeStamp(uint64_t time_stamp) const;
+
+  /**
+   * Return the smallest time_stamp, throws std::out_of_range if index is empty
+   */
+  uint64_t getStart() const;
+
+  /**
+   * Return the largest time_stamp, throws std::out_of_range if index is empty
+   */
+  uint64_t getEnd() const;
+
+private:
+  typedef std::pair<uint64_t, int> Entry;
+
+  /**
+   * Search in the time_stamps vector, requires monotonic time_stamps
+   */
+  int getMonotonicIndex(uint64_t time_stamp) const;
+
+  /**
+   * Search in the sorted_entries, used when time_stamps are not monotonic
+   */
+  int getSortedIndex(uint64_t time_stamp) const;
+
+  /**
+   * time_stamps[i] is the time_stamp of the entry with index first_index + i
+   */
+  std::vector<uint64_t> time_stamps;
+
+  int first_index;
+
+  /**
+   * Entries sorted by time_stamp without duplicates, only filled when time_stamps are not monotonic
+   */
+  std::vector<Entry> sorted_entries;
+
+  bool monotonic;
+};
+
+}  // namespace hl_monitoring
@@ -1,5 +1,7 @@
 #include <hl_monitoring/top_view_drawer.h>
 
+#include <hl_monitoring/profiler.h>
+
 #include <opencv2/imgproc.hpp>
 
 namespace hl_monitoring
@@ -17,28 +19,38 @@ TopViewDrawer::TopViewDrawer(const cv::Size& img_size)
   , blue_color(128, 35, 35)
   , red_color(126, 14, 104)
   , goals_disposition(GoalsDisposition::GoalsNeutral)
+  , background_version(0)
 {
 }
 
 void TopViewDrawer::setImgSize(const cv::Size& new_img_size)
 {
   img_size = new_img_size;
+  background = cv::Mat();
 }
 
 void TopViewDrawer::setGoalsDisposition(TopViewDrawer::GoalsDisposition goals_disposition_)
 {
   goals_disposition = goals_disposition_;
+  background = cv::Mat();
 }
 
 cv::Mat TopViewDrawer::getImg(const Field& f) const
 {
-  cv::Mat result(img_size, CV_8UC3, background_color);
-  drawTurf(f, &result);
-  drawLines(f, &result);
-  drawCenter(f, &result);
-  drawPenaltyMarks(f, &result);
-  drawGoals(f, &result);
-  return result;
+  ScopedTimer timer("TopViewDrawer::getImg");
+  uint64_t field_version = f.getVersion();
+  if (background.empty() || field_version != background_version)
+  {
+    background = cv::Mat(img_size, CV_8UC3, background_color);
+    drawTurf(f, &background);
+    drawLines(f, &background);
+    drawCenter(f, &background);
+    drawPenaltyMarks(f, &background);
+    drawGoals(f, &background);
+    background_version = field_version;
+  }
+  // Callers draw on the result, the background has to stay untouched
+  return background.clone();
 }
 
 double TopViewDrawer::getScale(const Field& f) const
@@ -4,6 +4,12 @@
 
 namespace hl_monitoring
 {
+/**
+ * Draws a top view of the field.
+ *
+ * The static part of the image (turf, lines and goals) is rendered once and kept until the size of the image, the
+ * goals disposition or the dimensions of the field change.
+ */
 class TopViewDrawer
 {
 public:
@@ -28,7 +34,7 @@ public:
   void setGoalsDisposition(GoalsDisposition goals_disposition);
 
   /**
-   * Return an Image with the field drawn on it
+   * Return an Image with the field drawn on it, the returned image can be modified freely
    */
   cv::Mat getImg(const Field& f) const;
 
@@ -84,6 +90,16 @@ private:
    */
   GoalsDisposition goals_disposition;
 
+  /**
+   * The last image of the field rendered, empty if it has to be rendered again
+   */
+  mutable cv::Mat background;
+
+  /**
+   * The version of the field used to render background, see Field::getVersion
+   */
+  mutable uint64_t background_version;
+
   /**
    * Return the width of the lines on image
    */
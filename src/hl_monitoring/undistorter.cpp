@@ -0,0 +1,163 @@
+#include "hl_monitoring/undistorter.h"
+
+#include <hl_communication/utils.h>
+#include <hl_monitoring/profiler.h>
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <sstream>
+
+using namespace hl_communication;
+
+namespace hl_monitoring
+{
+/**
+ * Above this number of entries, meta information of destroyed sources are removed
+ */
+static const size_t max_metas_before_cleanup = 64;
+
+Undistorter::Undistorter(size_t nb_threads_) : nb_threads(std::max((size_t)1, nb_threads_))
+{
+}
+
+cv::Mat Undistorter::undistort(const cv::Mat& img, const IntrinsicParameters& camera_parameters)
+{
+  ScopedTimer timer("Undistorter::undistort");
+  std::shared_ptr<const Maps> img_maps = getMaps(camera_parameters);
+  if (img.size() != img_maps->img_size)
+  {
+    std::ostringstream oss;
+    oss << HL_DEBUG << " size mismatch " << img.size() << " != " << img_maps->img_size;
+    throw std::runtime_error(oss.str());
+  }
+  std::shared_ptr<ThreadPool> pool;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (nb_threads > 1 && !thread_pool)
+    {
+      thread_pool.reset(new ThreadPool(nb_threads));
+    }
+    pool = thread_pool;
+  }
+  cv::Mat result(img.size(), img.type());
+  int nb_bands = pool ? (int)std::min((size_t)img.rows, pool->getNbThreads()) : 1;
+  // Each band of the result only depends on the same rows of the maps, the whole source is readable by all bands
+  auto remapBand = [&img, &result, &img_maps, nb_bands](int band) {
+    cv::Range rows(band * result.rows / nb_bands, (band + 1) * result.rows / nb_bands);
+    cv::Mat dst_band = result.rowRange(rows);
+    cv::remap(img, dst_band, img_maps->map1.rowRange(rows), img_maps->map2.rowRange(rows), cv::INTER_LINEAR);
+  };
+  if (nb_bands <= 1)
+  {
+    remapBand(0);
+    return result;
+  }
+  std::vector<std::future<void>> bands;
+  for (int band = 0; band < nb_bands; band++)
+  {
+    bands.push_back(pool->submit([&remapBand, band]() { remapBand(band); }));
+  }
+  // All bands have to be finished before returning since they reference local variables
+  std::exception_ptr error;
+  for (std::future<void>& band : bands)
+  {
+    try
+    {
+      band.get();
+    }
+    catch (...)
+    {
+      error = std::current_exception();
+    }
+  }
+  if (error)
+  {
+    std::rethrow_exception(error);
+  }
+  return result;
+}
+
+IntrinsicParameters Undistorter::getUndistortedParameters(const IntrinsicParameters& camera_parameters)
+{
+  cv::Mat camera_matrix, distortion_coefficients;
+  cv::Size img_size;
+  intrinsicToCV(camera_parameters, &camera_matrix, &distortion_coefficients, &img_size);
+  IntrinsicParameters result;
+  cvToIntrinsic(camera_matrix, cv::Mat::zeros(distortion_coefficients.size(), distortion_coefficients.type()),
+                img_size, &result);
+  return result;
+}
+
+std::shared_ptr<const CameraMetaInformation>
+Undistorter::getUndistortedMeta(const std::shared_ptr<const CameraMetaInformation>& camera_meta)
+{
+  if (!camera_meta || !camera_meta->has_camera_parameters())
+  {
+    return camera_meta;
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = metas.find(camera_meta.get());
+  // The address of a destroyed source might be reused by a new one
+  if (it != metas.end() && it->second.source.lock() == camera_meta)
+  {
+    return it->second.undistorted;
+  }
+  if (metas.size() >= max_metas_before_cleanup)
+  {
+    for (auto entry = metas.begin(); entry != metas.end();)
+    {
+      entry = entry->second.source.expired() ? metas.erase(entry) : std::next(entry);
+    }
+  }
+  std::shared_ptr<CameraMetaInformation> undistorted = std::make_shared<CameraMetaInformation>(*camera_meta);
+  undistorted->mutable_camera_parameters()->CopyFrom(getUndistortedParameters(camera_meta->camera_parameters()));
+  MetaEntry& entry = metas[camera_meta.get()];
+  entry.source = camera_meta;
+  entry.undistorted = std::move(undistorted);
+  return entry.undistorted;
+}
+
+void Undistorter::setNbThreads(size_t new_nb_threads)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  nb_threads = std::max((size_t)1, new_nb_threads);
+  thread_pool.reset();
+}
+
+void Undistorter::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  maps.clear();
+  metas.clear();
+}
+
+Undistorter& Undistorter::getDefault()
+{
+  static Undistorter undistorter;
+  return undistorter;
+}
+
+std::shared_ptr<const Undistorter::Maps> Undistorter::getMaps(const IntrinsicParameters& camera_parameters)
+{
+  std::string key = camera_parameters.SerializeAsString();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = maps.find(key);
+    if (it != maps.end())
+    {
+      return it->second;
+    }
+  }
+  // Maps are built without holding the lock, if two threads build the same maps, the first one inserted is kept
+  ScopedTimer timer("Undistorter::buildMaps");
+  cv::Mat camera_matrix, distortion_coefficients;
+  std::shared_ptr<Maps> new_maps = std::make_shared<Maps>();
+  intrinsicToCV(camera_parameters, &camera_matrix, &distortion_coefficients, &new_maps->img_size);
+  cv::initUndistortRectifyMap(camera_matrix, distortion_coefficients, cv::Mat(), camera_matrix, new_maps->img_size,
+                              CV_16SC2, new_maps->map1, new_maps->map2);
+  std::lock_guard<std::mutex> lock(mutex);
+  return maps.emplace(key, std::move(new_maps)).first->second;
+}
+
+}  // namespace hl_monitoring
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "hl_communication/camera.pb.h"
+#include "hl_monitoring/thread_pool.h"
+
+#include <opencv2/core.hpp>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace hl_monitoring
+{
+/**
+ * Removes the distortion from images based on their intrinsic parameters.
+ *
+ * The undistortion maps are computed once for each set of intrinsic parameters and kept in fixed-point format, so that
+ * undistorting an image only costs a remap. The meta information of undistorted images is shared as long as the source
+ * meta information is shared. All methods are thread-safe.
+ */
+class Undistorter
+{
+public:
+  /**
+   * nb_threads: number of threads used to remap bands of rows of the same image, 1 to remap in the calling thread
+   */
+  Undistorter(size_t nb_threads = 1);
+
+  /**
+   * Return the undistorted version of img, which has to be of the size specified in camera_parameters. The result
+   * can be described by getUndistortedParameters(camera_parameters).
+   */
+  cv::Mat undistort(const cv::Mat& img, const hl_communication::IntrinsicParameters& camera_parameters);
+
+  /**
+   * Return the parameters of the camera after undistortion: same camera matrix, no distortion
+   */
+  static hl_communication::IntrinsicParameters
+  getUndistortedParameters(const hl_communication::IntrinsicParameters& camera_parameters);
+
+  /**
+   * Return a handle on camera_meta with undistorted camera parameters, the same handle is returned as long as
+   * camera_meta is alive.
+   */
+  std::shared_ptr<const hl_communication::CameraMetaInformation>
+  getUndistortedMeta(const std::shared_ptr<const hl_communication::CameraMetaInformation>& camera_meta);
+
+  /**
+   * Set the number of threads used to remap a single image, 1 to remap in the calling thread
+   */
+  void setNbThreads(size_t nb_threads);
+
+  /**
+   * Forget all the undistortion maps and meta information
+   */
+  void clear();
+
+  /**
+   * Undistorter shared by all the images and providers of the process
+   */
+  static Undistorter& getDefault();
+
+private:
+  struct Maps
+  {
+    cv::Size img_size;
+    /**
+     * Fixed-point maps as produced by cv::initUndistortRectifyMap with CV_16SC2
+     */
+    cv::Mat map1;
+    cv::Mat map2;
+  };
+
+  struct MetaEntry
+  {
+    std::weak_ptr<const hl_communication::CameraMetaInformation> source;
+    std::shared_ptr<const hl_communication::CameraMetaInformation> undistorted;
+  };
+
+  /**
+   * Return the maps associated to the given parameters, building them if necessary
+   */
+  std::shared_ptr<const Maps> getMaps(const hl_communication::IntrinsicParameters& camera_parameters);
+
+  /**
+   * Protects all the members below
+   */
+  std::mutex mutex;
+
+  /**
+   * Maps indexed by the serialized intrinsic parameters
+   */
+  std::map<std::string, std::shared_ptr<const Maps>> maps;
+
+  /**
+   * Undistorted meta information indexed by the address of the source, entries are removed once the source is
+   * destroyed
+   */
+  std::map<const hl_communication::CameraMetaInformation*, MetaEntry> metas;
+
+  size_t nb_threads;
+
+  /**
+   * Workers remapping the bands, built on first use. Shared with the running calls, so that changing the number of
+   * threads does not destroy a pool in use.
+   */
+  std::shared_ptr<ThreadPool> thread_pool;
+};
+
+}  // namespace hl_monitoring
@@ -0,0 +1,351 @@
+#include "hl_monitoring/video_writer_stage.h"
+
+#include <hl_communication/utils.h>
+
+#include <iostream>
+
+using namespace hl_communication;
+
+namespace hl_monitoring
+{
+VideoWriterStage::DropPolicy VideoWriterStage::string2DropPolicy(const std::string& str)
+{
+  for (DropPolicy policy : { DropPolicy::DropNewest, DropPolicy::DropOldest, DropPolicy::Block })
+  {
+    if (dropPolicy2String(policy) == str)
+    {
+      return policy;
+    }
+  }
+  throw std::out_of_range(HL_DEBUG + " cannot convert str '" + str + "' to drop policy");
+}
+
+std::string VideoWriterStage::dropPolicy2String(DropPolicy policy)
+{
+  switch (policy)
+  {
+    case DropPolicy::DropNewest:
+      return "DropNewest";
+    case DropPolicy::DropOldest:
+      return "DropOldest";
+    case DropPolicy::Block:
+      return "Block";
+  }
+  throw std::logic_error(HL_DEBUG + " unknown drop policy");
+}
+
+VideoWriterStage::VideoWriterStage(size_t max_queue_size, DropPolicy drop_policy)
+  : use_jpeg_chunks(false)
+  , max_queue_size(max_queue_size)
+  , drop_policy(drop_policy)
+  , codec("XVID")
+  , container("avi")
+  , jpeg_quality(90)
+  , closing(false)
+{
+}
+
+VideoWriterStage::~VideoWriterStage()
+{
+  close();
+}
+
+void VideoWriterStage::open(const std::string& path, int fourcc, double fps, const cv::Size& size, bool use_color)
+{
+  if (isOpened())
+  {
+    throw std::logic_error(HL_DEBUG + " video writer is already opened");
+  }
+  use_jpeg_chunks = isJpegChunkPath(path);
+  if (use_jpeg_chunks)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      jpeg_output.setQuality(jpeg_quality);
+    }
+    jpeg_output.open(path);
+  }
+  else
+  {
+    output.open(path, fourcc, fps, size, use_color);
+    if (!output.isOpened())
+    {
+      throw std::runtime_error(HL_DEBUG + "Failed to open video at '" + path + "'");
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    closing = false;
+    statistics = Statistics();
+  }
+  thread = std::thread(&VideoWriterStage::run, this);
+}
+
+void VideoWriterStage::openMetaInformation(const std::string& path, const VideoMetaInformation& header)
+{
+  meta_writer.open(path);
+  meta_writer.writeHeader(header);
+}
+
+void VideoWriterStage::writeHeader(const VideoMetaInformation& header)
+{
+  if (meta_writer.isOpened())
+  {
+    meta_writer.writeHeader(header);
+  }
+}
+
+void VideoWriterStage::writeFrameUpdate(const FrameEntry& entry)
+{
+  if (meta_writer.isOpened())
+  {
+    meta_writer.writeFrameUpdate(entry);
+  }
+}
+
+bool VideoWriterStage::isOpened() const
+{
+  return thread.joinable();
+}
+
+void VideoWriterStage::close()
+{
+  if (!isOpened())
+  {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    closing = true;
+  }
+  job_available.notify_all();
+  thread.join();
+  output.release();
+  jpeg_output.close();
+  meta_writer.close();
+}
+
+bool VideoWriterStage::push(const cv::Mat& img, const FrameEntry& entry)
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  statistics.nb_pushed++;
+  if (queue.size() >= max_queue_size)
+  {
+    switch (drop_policy)
+    {
+      case DropPolicy::DropNewest:
+        statistics.nb_dropped++;
+        return false;
+      case DropPolicy::DropOldest:
+        queue.pop_front();
+        statistics.nb_dropped++;
+        break;
+      case DropPolicy::Block:
+      {
+        uint64_t wait_start = getTimeStamp();
+        space_available.wait(lock, [this]() { return queue.size() < max_queue_size || closing; });
+        statistics.blocked_time += getTimeStamp() - wait_start;
+        break;
+      }
+    }
+  }
+  queue.push_back({ img, entry });
+  statistics.max_queue_size = std::max(statistics.max_queue_size, queue.size());
+  lock.unlock();
+  job_available.notify_one();
+  return true;
+}
+
+VideoWriterStage::Statistics VideoWriterStage::getStatistics() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return statistics;
+}
+
+void VideoWriterStage::setMaxQueueSize(size_t new_size)
+{
+  if (new_size == 0)
+  {
+    throw std::logic_error(HL_DEBUG + " queue size should be strictly positive");
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    max_queue_size = new_size;
+  }
+  space_available.notify_all();
+}
+
+void VideoWriterStage::setDropPolicy(DropPolicy new_policy)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  drop_policy = new_policy;
+}
+
+void VideoWriterStage::setCodec(const std::string& new_codec)
+{
+  if (new_codec.size() != 4)
+  {
+    throw std::invalid_argument(HL_DEBUG + " invalid codec '" + new_codec + "': expecting a four character code");
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  codec = new_codec;
+}
+
+std::string VideoWriterStage::getCodec() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return codec;
+}
+
+int VideoWriterStage::getFourcc() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return cv::VideoWriter::fourcc(codec[0], codec[1], codec[2], codec[3]);
+}
+
+void VideoWriterStage::setContainer(const std::string& new_container)
+{
+  if (new_container == "" || new_container.find_first_of("./") != std::string::npos)
+  {
+    throw std::invalid_argument(HL_DEBUG + " invalid container '" + new_container + "': expecting a file extension");
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  container = new_container;
+}
+
+std::string VideoWriterStage::getContainer() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return container;
+}
+
+std::string VideoWriterStage::getVideoPath(const std::string& prefix) const
+{
+  return prefix + "." + getContainer();
+}
+
+void VideoWriterStage::setJpegQuality(int quality)
+{
+  if (quality < 0 || quality > 100)
+  {
+    throw std::out_of_range(HL_DEBUG + " invalid jpeg quality: " + std::to_string(quality));
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  jpeg_quality = quality;
+}
+
+Json::Value VideoWriterStage::toJson() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  Json::Value v;
+  v["queue_size"] = (Json::UInt64)max_queue_size;
+  v["drop_policy"] = dropPolicy2String(drop_policy);
+  v["codec"] = codec;
+  v["container"] = container;
+  v["jpeg_quality"] = jpeg_quality;
+  return v;
+}
+
+void VideoWriterStage::fromJson(const Json::Value& v)
+{
+  int queue_size = -1;
+  std::string policy_str;
+  tryReadVal(v, "queue_size", &queue_size);
+  tryReadVal(v, "drop_policy", &policy_str);
+  if (queue_size >= 0)
+  {
+    setMaxQueueSize(queue_size);
+  }
+  if (policy_str != "")
+  {
+    setDropPolicy(string2DropPolicy(policy_str));
+  }
+  std::string codec_str, container_str;
+  tryReadVal(v, "codec", &codec_str);
+  tryReadVal(v, "container", &container_str);
+  if (codec_str != "")
+  {
+    setCodec(codec_str);
+  }
+  if (container_str != "")
+  {
+    setContainer(container_str);
+  }
+  if (v.isMember("jpeg_quality"))
+  {
+    int quality;
+    readVal(v, "jpeg_quality", &quality);
+    setJpegQuality(quality);
+  }
+}
+
+bool VideoWriterStage::writeJpegChunk(const cv::Mat& img)
+{
+  if (!jpeg_output.isOpened())
+  {
+    return false;
+  }
+  try
+  {
+    jpeg_output.write(img);
+  }
+  catch (const std::runtime_error& exc)
+  {
+    // The stream keeps failing once an error occurred, following images are dropped
+    std::cerr << HL_DEBUG << "Failed to write image, closing jpeg chunk file: " << exc.what() << std::endl;
+    jpeg_output.close();
+    return false;
+  }
+  return true;
+}
+
+void VideoWriterStage::run()
+{
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true)
+  {
+    job_available.wait(lock, [this]() { return queue.size() > 0 || closing; });
+    if (queue.size() == 0)
+    {
+      // closing has been requested and all the jobs have been treated
+      return;
+    }
+    Job job = std::move(queue.front());
+    queue.pop_front();
+    lock.unlock();
+    space_available.notify_one();
+    bool written = true;
+    if (use_jpeg_chunks)
+    {
+      written = writeJpegChunk(job.img);
+    }
+    else
+    {
+      output.write(job.img);
+    }
+    if (!written)
+    {
+      // The entry is not written, so that the meta information still matches the images available
+      lock.lock();
+      statistics.nb_dropped++;
+      continue;
+    }
+    if (meta_writer.isOpened())
+    {
+      try
+      {
+        meta_writer.writeFrame(job.entry);
+      }
+      catch (const std::runtime_error& exc)
+      {
+        // Encoding goes on, but entries can not be saved anymore
+        std::cerr << HL_DEBUG << "Failed to write meta information: " << exc.what() << std::endl;
+        meta_writer.close();
+      }
+    }
+    lock.lock();
+    statistics.nb_written++;
+  }
+}
+
+}  // namespace hl_monitoring
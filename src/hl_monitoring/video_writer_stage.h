@@ -0,0 +1,215 @@
+#pragma once
+
+#include "hl_monitoring/jpeg_chunk_log.h"
+#include "hl_monitoring/meta_information_log.h"
+
+#include <hl_communication/camera.pb.h>
+
+#include <json/json.h>
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace hl_monitoring
+{
+/**
+ * Encodes images in a video file from a dedicated thread, so that encoding stalls do not delay the acquisition.
+ *
+ * Images are stored in a bounded queue while waiting to be encoded, the behavior when the queue is full depends on the
+ * DropPolicy. If meta information is opened, the FrameEntry associated to each image is appended to it once the image
+ * is written, so that the meta information always matches the content of the video, even if some images were dropped.
+ *
+ * Videos whose extension is 'jpegs' are written with a JpegChunkWriter instead of cv::VideoWriter, this intra-only
+ * format is meant for recordings which are mostly scrubbed during replay.
+ */
+class VideoWriterStage
+{
+public:
+  /**
+   * What happens when an image is pushed while the queue is full
+   */
+  enum DropPolicy
+  {
+    /**
+     * The image pushed is discarded
+     */
+    DropNewest,
+    /**
+     * The oldest image of the queue is discarded
+     */
+    DropOldest,
+    /**
+     * The producer waits until there is space in the queue, no images are lost
+     */
+    Block
+  };
+
+  static DropPolicy string2DropPolicy(const std::string& str);
+  static std::string dropPolicy2String(DropPolicy policy);
+
+  /**
+   * Back-pressure statistics of the stage since it was opened
+   */
+  struct Statistics
+  {
+    uint64_t nb_pushed = 0;
+    uint64_t nb_written = 0;
+    uint64_t nb_dropped = 0;
+    /**
+     * Largest number of images waiting in the queue
+     */
+    size_t max_queue_size = 0;
+    /**
+     * Total time spent by producers waiting for space in the queue [us]
+     */
+    uint64_t blocked_time = 0;
+  };
+
+  VideoWriterStage(size_t max_queue_size = 32, DropPolicy drop_policy = DropPolicy::DropNewest);
+  ~VideoWriterStage();
+
+  /**
+   * Open the video file and start the encoding thread, throws a runtime_error on failure. fourcc, fps and use_color
+   * are ignored for JPEG chunk files.
+   */
+  void open(const std::string& path, int fourcc, double fps, const cv::Size& size, bool use_color = true);
+
+  bool isOpened() const;
+
+  /**
+   * Start writing the entries of the images encoded to a streamed meta information file, see MetaInformationWriter.
+   * Has to be called before pushing images.
+   */
+  void openMetaInformation(const std::string& path, const hl_communication::VideoMetaInformation& header);
+
+  /**
+   * Update the information shared by all the frames, ignored if meta information is not opened
+   */
+  void writeHeader(const hl_communication::VideoMetaInformation& header);
+
+  /**
+   * Update an entry already pushed, see MetaInformationWriter::writeFrameUpdate. Ignored if meta information is not
+   * opened.
+   */
+  void writeFrameUpdate(const hl_communication::FrameEntry& entry);
+
+  /**
+   * Wait until all images in the queue are written, then close the video file and the meta information
+   */
+  void close();
+
+  /**
+   * Add an image to the encoding queue along with its entry. Returns false if the image was dropped.
+   * The content of 'img' should not be modified after this call.
+   */
+  bool push(const cv::Mat& img, const hl_communication::FrameEntry& entry);
+
+  Statistics getStatistics() const;
+
+  void setMaxQueueSize(size_t new_size);
+  void setDropPolicy(DropPolicy new_policy);
+
+  /**
+   * Codec used to encode the video as a four character code, e.g. 'XVID', 'MJPG' or 'H264'. 'MJPG' only produces
+   * intra frames: encoding is cheap and every frame is a keyframe, at the cost of larger files.
+   * Throws an invalid_argument if the code is not made of 4 characters.
+   */
+  void setCodec(const std::string& new_codec);
+  std::string getCodec() const;
+
+  /**
+   * The FOURCC of the codec as expected by cv::VideoWriter
+   */
+  int getFourcc() const;
+
+  /**
+   * Extension of the video file, which defines the container used, e.g. 'avi', 'mkv' or 'mp4'. With 'jpegs', images
+   * are written as a JPEG chunk file, see JpegChunkWriter, and the codec is ignored.
+   * Throws an invalid_argument if the extension is empty or contains a '.' or a '/'.
+   */
+  void setContainer(const std::string& new_container);
+  std::string getContainer() const;
+
+  /**
+   * Path of the video file associated to the given prefix: '<prefix>.<container>'
+   */
+  std::string getVideoPath(const std::string& prefix) const;
+
+  /**
+   * Quality of the images written in JPEG chunk files, in [0, 100]. Takes effect on the next opening.
+   */
+  void setJpegQuality(int quality);
+
+  Json::Value toJson() const;
+  void fromJson(const Json::Value& v);
+
+private:
+  struct Job
+  {
+    cv::Mat img;
+    hl_communication::FrameEntry entry;
+  };
+
+  void run();
+
+  /**
+   * Write the image in jpeg_output, closes it on failure. Returns false if the image was not written.
+   */
+  bool writeJpegChunk(const cv::Mat& img);
+
+  cv::VideoWriter output;
+
+  /**
+   * Used instead of 'output' for JPEG chunk files
+   */
+  JpegChunkWriter jpeg_output;
+
+  /**
+   * Are images written in jpeg_output, only modified while the encoding thread is not running
+   */
+  bool use_jpeg_chunks;
+
+  /**
+   * Entries of the images written, thread-safe since the header is written by the producer
+   */
+  MetaInformationWriter meta_writer;
+
+  std::thread thread;
+
+  /**
+   * Protects all the members below
+   */
+  mutable std::mutex mutex;
+
+  /**
+   * Notified when a job is added or when closing is requested
+   */
+  std::condition_variable job_available;
+
+  /**
+   * Notified when a job is removed from the queue
+   */
+  std::condition_variable space_available;
+
+  std::deque<Job> queue;
+
+  size_t max_queue_size;
+
+  DropPolicy drop_policy;
+
+  std::string codec;
+
+  std::string container;
+
+  int jpeg_quality;
+
+  bool closing;
+
+  Statistics statistics;
+};
+
+}  // namespace hl_monitoring
@@ -6,7 +6,9 @@
  */
 #include <hl_communication/utils.h>
 #include <hl_monitoring/field.h>
+#include <hl_monitoring/field_lines_projection.h>
 #include <hl_monitoring/monitoring_manager.h>
+#include <hl_monitoring/profiler.h>
 #include <hl_monitoring/drawers/team_drawer.h>
 
 #include <opencv2/imgproc.hpp>
@@ -22,11 +24,16 @@ int main(int argc, char** argv)
 
   TCLAP::ValueArg<std::string> config_arg("c", "config", "The path to the json configuration file", true, "config.json",
                                           "string");
-  TCLAP::ValueArg<std::string> field_arg("f", "field", "The path to the json description of the file", true,
-                                         "field.json", "string");
+  TCLAP::ValueArg<std::string> profile_arg("p", "profile",
+                                           "If set, timings of the stages are periodically written to this json file",
+                                           false, "", "string");
+  TCLAP::ValueArg<double> summary_period_arg("s", "summary-period",
+                                             "Period between two summaries of the timings in verbose mode [s]", false,
+                                             5.0, "double");
   TCLAP::SwitchArg verbose_arg("v", "verbose", "If enabled display all messages received", cmd, false);
   cmd.add(config_arg);
-  cmd.add(field_arg);
+  cmd.add(profile_arg);
+  cmd.add(summary_period_arg);
 
   try
   {
@@ -41,20 +48,30 @@ int main(int argc, char** argv)
 
   manager.loadConfig(config_arg.getValue());
 
-  Field field;
-  field.loadFile(field_arg.getValue());
+  // Dimensions tuned over RhIO are applied by manager.update(), drawers detect the modification through the version
+  const Field& field = manager.getField();
 
   // While exit was not explicitly required, run
   uint64_t now = 0;
-  uint64_t dt = 30 * 1000;  //[microseconds]
+  // Projection of the lines is kept for each source and only updated when camera parameters change
+  std::map<std::string, FieldLinesProjection> lines_projections;
+  // Drawers keep their rendering caches between iterations
+  TopViewDrawer top_view_drawer(cv::Size(1200, 800));
+  TeamDrawer team_drawer;
   if (!manager.isLive())
   {
     now = manager.getStart();
     manager.setOffset(getSteadyClockOffset());
+    // All streams are replayed on the same timeline, whatever the time spent to display them
+    manager.getPlaybackClock().seek(now);
+    manager.getPlaybackClock().play();
   }
+  Profiler& profiler = Profiler::getDefault();
+  uint64_t summary_period = summary_period_arg.getValue() * 1000 * 1000;  //[microseconds]
+  uint64_t last_summary = getTimeStamp();
   while (manager.isGood())
   {
-    int64_t loop_start = getTimeStamp();
+    ScopedTimer loop_timer("loop");
     manager.update();
     if (manager.isLive())
     {
@@ -62,13 +79,15 @@ int main(int argc, char** argv)
     }
     else
     {
-      now += dt;
+      now = manager.getPlaybackClock().getTime();
     }
-    int64_t post_manager_update = getTimeStamp();
 
     uint64_t history_length = 2 * 1000 * 1000;  //[us]
-    MessageManager::Status status = manager.getMessageManager().getStatus(now, history_length);
-    int64_t post_get_status = getTimeStamp();
+    MessageManager::Status status;
+    {
+      ScopedTimer timer("MessageManager::getStatus");
+      status = manager.getMessageManager().getStatus(now, history_length);
+    }
 
     if (verbose_arg.getValue())
     {
@@ -82,11 +101,7 @@ int main(int argc, char** argv)
       }
     }
 
-    std::map<std::string, CalibratedImage> images_by_source = manager.getCalibratedImages(now);
-    int64_t post_get_images = getTimeStamp();
-
-    TopViewDrawer top_view_drawer(cv::Size(1200, 800));
-    TeamDrawer team_drawer;
+    std::map<std::string, CalibratedImage> images_by_source = manager.getSynchronizedImages(now);
 
     // Annotation of provided images
     for (const auto& entry : images_by_source)
@@ -95,7 +110,7 @@ int main(int argc, char** argv)
       if (entry.second.isFullySpecified())
       {
         const CameraMetaInformation& camera_information = entry.second.getCameraInformation();
-        field.tagLines(camera_information, &display_img, cv::Scalar(0, 0, 0), 1, 10);
+        lines_projections[entry.first].tagLines(field, entry.second, &display_img, cv::Scalar(0, 0, 0), 1, 10);
         team_drawer.drawNatural(camera_information, status, &display_img);
       }
       cv::imshow(entry.first, display_img);
@@ -105,20 +120,40 @@ int main(int argc, char** argv)
     team_drawer.drawTopView(field, top_view_drawer, status, &top_view);
     cv::imshow("TopView", top_view);
 
-    int64_t post_annotation = getTimeStamp();
     char key = cv::waitKey(1);
     if (key == 'q' || key == 'Q')
     {
       break;
     }
+    else if (key == ' ' && !manager.isLive())
+    {
+      PlaybackClock& clock = manager.getPlaybackClock();
+      if (clock.isPaused())
+      {
+        clock.play();
+      }
+      else
+      {
+        clock.pause();
+      }
+    }
 
-    if (verbose_arg.getValue())
+    uint64_t loop_end = getTimeStamp();
+    if (loop_end - last_summary > summary_period)
     {
-      std::cout << "\tUpdate time: " << ((post_manager_update - loop_start) / 1000) << std::endl;
-      std::cout << "\tGet status time: " << ((post_get_status - post_manager_update) / 1000) << std::endl;
-      std::cout << "\tGet images time: " << ((post_get_images - post_get_status) / 1000) << std::endl;
-      std::cout << "\tManager update time: " << ((post_annotation - post_get_images) / 1000) << std::endl;
-      std::cout << "Total time: " << ((post_annotation - loop_start) / 1000) << " ms" << std::endl;
+      if (verbose_arg.getValue())
+      {
+        std::cout << profiler.getSummary();
+      }
+      if (profile_arg.getValue() != "")
+      {
+        profiler.writeFile(profile_arg.getValue());
+      }
+      last_summary = loop_end;
     }
   }
+  if (profile_arg.getValue() != "")
+  {
+    profiler.writeFile(profile_arg.getValue());
+  }
 }
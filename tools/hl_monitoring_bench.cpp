@@ -0,0 +1,324 @@
+/**
+ * Measure the duration of the hot paths of replay and drawing on synthetic data.
+ *
+ * A video is generated in a temporary directory, robots messages and camera parameters are built programmatically, so
+ * that results only depend on the version of the code and on the host. Results are written as json with durations in
+ * microseconds, keys of the output are stable between versions.
+ */
+#include <hl_communication/utils.h>
+#include <hl_monitoring/field.h>
+#include <hl_monitoring/field_lines_projection.h>
+#include <hl_monitoring/jpeg_chunk_log.h>
+#ifdef HL_MONITORING_USES_LIBAV
+#include <hl_monitoring/libav_replay_image_provider.h>
+#endif
+#include <hl_monitoring/profiler.h>
+#include <hl_monitoring/replay_image_provider.h>
+#include <hl_monitoring/top_view_drawer.h>
+#include <hl_monitoring/drawers/team_drawer.h>
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/videoio.hpp>
+#include <tclap/CmdLine.h>
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+
+using namespace hl_communication;
+using namespace hl_monitoring;
+
+/**
+ * Version of the format of the output, has to be incremented when keys are renamed or removed
+ */
+static const int schema_version = 1;
+
+/**
+ * Seed used for all random generators, ensures that all runs use the same data
+ */
+static const unsigned int seed = 42;
+
+/**
+ * Call 'function' nb_iterations times and return the distribution of its durations [us]
+ */
+template <typename F>
+TimingHistogram measure(int nb_iterations, F function)
+{
+  TimingHistogram histogram;
+  for (int iteration = 0; iteration < nb_iterations; iteration++)
+  {
+    uint64_t start = getTimeStamp();
+    function(iteration);
+    histogram.add(getTimeStamp() - start);
+  }
+  return histogram;
+}
+
+/**
+ * Write a video with moving content, so that the encoder produces a realistic group of pictures structure
+ */
+void generateVideo(const std::string& path, int nb_frames, const cv::Size& size, double fps)
+{
+  cv::VideoWriter writer(path, cv::VideoWriter::fourcc('X', 'V', 'I', 'D'), fps, size, true);
+  if (!writer.isOpened())
+  {
+    throw std::runtime_error(HL_DEBUG + " failed to open video '" + path + "'");
+  }
+  std::mt19937 engine(seed);
+  cv::Mat noise(size, CV_8UC3);
+  for (int idx = 0; idx < nb_frames; idx++)
+  {
+    cv::Mat img(size, CV_8UC3, cv::Scalar(0, 120, 0));
+    cv::randu(noise, cv::Scalar::all(0), cv::Scalar::all(30));
+    img += noise;
+    int x = (idx * 7) % size.width;
+    cv::circle(img, cv::Point(x, size.height / 2), 30, cv::Scalar(255, 255, 255), cv::FILLED);
+    cv::putText(img, std::to_string(idx), cv::Point(20, 50), cv::FONT_HERSHEY_SIMPLEX, 1.5, cv::Scalar(0, 0, 0), 3);
+    writer.write(img);
+  }
+}
+
+/**
+ * Write all the frames of the video in a JPEG chunk file
+ */
+void generateJpegChunk(const std::string& video_path, const std::string& chunk_path)
+{
+  cv::VideoCapture video(video_path);
+  if (!video.isOpened())
+  {
+    throw std::runtime_error(HL_DEBUG + " failed to open video '" + video_path + "'");
+  }
+  JpegChunkWriter writer;
+  writer.open(chunk_path);
+  cv::Mat img;
+  while (video.read(img))
+  {
+    writer.write(img);
+  }
+}
+
+/**
+ * Camera at the corner of the field, looking at the center of the field
+ */
+std::shared_ptr<const CameraMetaInformation> buildCameraMetaInformation(const cv::Size& size)
+{
+  cv::Mat camera_matrix = (cv::Mat_<double>(3, 3) << 600, 0, size.width / 2, 0, 600, size.height / 2, 0, 0, 1);
+  cv::Mat distortion = (cv::Mat_<double>(1, 5) << -0.1, 0.01, 0, 0, 0);
+  cv::Vec3d camera_pos(-5.5, -4.5, 2.5);
+  cv::Vec3d target(0, 0, 0);
+  cv::Vec3d z_axis = cv::normalize(target - camera_pos);
+  cv::Vec3d x_axis = cv::normalize(z_axis.cross(cv::Vec3d(0, 0, 1)));
+  cv::Vec3d y_axis = z_axis.cross(x_axis);
+  cv::Matx33d rotation(x_axis[0], x_axis[1], x_axis[2], y_axis[0], y_axis[1], y_axis[2], z_axis[0], z_axis[1],
+                       z_axis[2]);
+  cv::Mat rvec, tvec = cv::Mat(-(rotation * camera_pos));
+  cv::Rodrigues(cv::Mat(rotation), rvec);
+  std::shared_ptr<CameraMetaInformation> camera_meta = std::make_shared<CameraMetaInformation>();
+  cvToIntrinsic(camera_matrix, distortion, size, camera_meta->mutable_camera_parameters());
+  cvToPose3D(rvec, tvec, camera_meta->mutable_pose());
+  return camera_meta;
+}
+
+/**
+ * Two teams of 6 robots spread on the field, with position and direction uncertainty and positioning intentions
+ */
+MessageManager::Status buildStatus()
+{
+  std::mt19937 engine(seed);
+  std::uniform_real_distribution<double> x_distrib(-4.5, 4.5);
+  std::uniform_real_distribution<double> y_distrib(-3, 3);
+  std::uniform_real_distribution<double> dir_distrib(-M_PI, M_PI);
+  MessageManager::Status status;
+  for (uint32_t team_id : { 1, 2 })
+  {
+    for (uint32_t robot_id = 1; robot_id <= 6; robot_id++)
+    {
+      RobotMsg msg;
+      msg.mutable_robot_id()->set_team_id(team_id);
+      msg.mutable_robot_id()->set_robot_id(robot_id);
+      PoseDistribution* pose = msg.mutable_perception()->add_self_in_field()->mutable_pose();
+      pose->mutable_position()->set_x(x_distrib(engine));
+      pose->mutable_position()->set_y(y_distrib(engine));
+      // Half of the robots provide the covariance of their position, so that uncertainty ellipses are drawn
+      if (robot_id % 2 == 1)
+      {
+        PositionDistribution* position = pose->mutable_position();
+        position->add_uncertainty(0.09);  // var(x)
+        position->add_uncertainty(0.02);  // cov(x, y)
+        position->add_uncertainty(0.04);  // var(y)
+      }
+      pose->mutable_dir()->set_mean(dir_distrib(engine));
+      pose->mutable_dir()->set_std_dev(0.2);
+      PositionDistribution* target = msg.mutable_intention()->mutable_target_pose_in_field()->mutable_position();
+      target->set_x(x_distrib(engine));
+      target->set_y(y_distrib(engine));
+      status.robot_messages[msg.robot_id()] = msg;
+    }
+  }
+  return status;
+}
+
+Json::Value benchReplay(const std::string& video_path, const std::string& chunk_path, int nb_frames)
+{
+  Json::Value v;
+  std::mt19937 engine(seed);
+  std::uniform_int_distribution<int> index_distrib(0, nb_frames - 1);
+  // A new provider is used for each access pattern, so that the cache starts empty
+  {
+    ReplayImageProvider provider(video_path);
+    v["sequential"] = measure(nb_frames, [&](int idx) { provider.getCalibratedImage(provider.getTimeStamp(idx)); })
+                          .toJson();
+  }
+  {
+    ReplayImageProvider provider(video_path);
+    v["random"] = measure(nb_frames, [&](int) {
+                    provider.getCalibratedImage(provider.getTimeStamp(index_distrib(engine)));
+                  }).toJson();
+  }
+  {
+    ReplayImageProvider provider(video_path);
+    v["backward"] = measure(nb_frames, [&](int idx) {
+                      provider.getCalibratedImage(provider.getTimeStamp(nb_frames - 1 - idx));
+                    }).toJson();
+  }
+  {
+    ReplayImageProvider provider(video_path);
+    uint64_t start = provider.getStart();
+    uint64_t end = provider.getEnd();
+    std::uniform_int_distribution<uint64_t> ts_distrib(start, end);
+    // A single call is too short to be measured, durations are given for batches of calls
+    int batch_size = 1000;
+    v["get_index_x1000"] = measure(1000, [&](int) {
+                             for (int call = 0; call < batch_size; call++)
+                             {
+                               provider.getIndex(ts_distrib(engine));
+                             }
+                           }).toJson();
+  }
+  {
+    JpegChunkReader reader;
+    reader.open(chunk_path);
+    v["jpeg_chunk_random"] = measure(nb_frames, [&](int) { reader.read(index_distrib(engine)); }).toJson();
+    v["jpeg_chunk_thumbnail_random"] = measure(nb_frames, [&](int) {
+                                         reader.read(index_distrib(engine), 4);
+                                       }).toJson();
+  }
+#ifdef HL_MONITORING_USES_LIBAV
+  {
+    LibavReplayImageProvider provider(video_path);
+    provider.setBufferPool(std::make_shared<ImageBufferPool>());
+    v["libav_sequential"] = measure(nb_frames, [&](int idx) {
+                              provider.getCalibratedImage(provider.getTimeStamp(idx));
+                            }).toJson();
+    v["libav_random"] = measure(nb_frames, [&](int) {
+                          provider.getCalibratedImage(provider.getTimeStamp(index_distrib(engine)));
+                        }).toJson();
+  }
+#endif
+  return v;
+}
+
+Json::Value benchField(const Field& field, const std::shared_ptr<const CameraMetaInformation>& camera_meta,
+                       const cv::Size& size, int nb_iterations)
+{
+  Json::Value v;
+  cv::Mat img(size, CV_8UC3, cv::Scalar(0, 120, 0));
+  for (int nb_segments : { 1, 10, 30 })
+  {
+    std::string suffix = "_" + std::to_string(nb_segments);
+    v["tag_lines" + suffix] = measure(nb_iterations, [&](int) {
+                                field.tagLines(*camera_meta, &img, cv::Scalar(0, 0, 0), 1, nb_segments);
+                              }).toJson();
+    FieldLinesProjection projection;
+    CalibratedImage calibrated_img(img, camera_meta);
+    v["cached_tag_lines" + suffix] = measure(nb_iterations, [&](int) {
+                                       projection.tagLines(field, calibrated_img, &img, cv::Scalar(0, 0, 0), 1,
+                                                           nb_segments);
+                                     }).toJson();
+  }
+  return v;
+}
+
+Json::Value benchDrawers(const Field& field, const std::shared_ptr<const CameraMetaInformation>& camera_meta,
+                         const cv::Size& size, int nb_iterations)
+{
+  Json::Value v;
+  MessageManager::Status status = buildStatus();
+  TopViewDrawer top_view_drawer(cv::Size(1200, 800));
+  TeamDrawer team_drawer;
+  v["top_view_get_img"] = measure(nb_iterations, [&](int) { top_view_drawer.getImg(field); }).toJson();
+  cv::Mat top_view = top_view_drawer.getImg(field);
+  v["team_drawer_top_view"] = measure(nb_iterations, [&](int) {
+                                team_drawer.drawTopView(field, top_view_drawer, status, &top_view);
+                              }).toJson();
+  cv::Mat natural_img(size, CV_8UC3, cv::Scalar(0, 120, 0));
+  v["team_drawer_natural"] = measure(nb_iterations, [&](int) {
+                               team_drawer.drawNatural(*camera_meta, status, &natural_img);
+                             }).toJson();
+  return v;
+}
+
+int main(int argc, char** argv)
+{
+  TCLAP::CmdLine cmd("Measure the duration of replay and drawing operations on synthetic data", ' ', "0.9");
+  TCLAP::ValueArg<std::string> output_arg("o", "output", "Path of the json output, printed if not provided", false, "",
+                                          "string", cmd);
+  TCLAP::ValueArg<std::string> tmp_arg("t", "tmp-dir", "Directory used for the generated video", false, "/tmp",
+                                       "string", cmd);
+  TCLAP::ValueArg<int> nb_frames_arg("n", "nb-frames", "Number of frames of the generated video", false, 300, "int",
+                                     cmd);
+  TCLAP::ValueArg<int> iterations_arg("i", "iterations", "Number of iterations for drawing operations", false, 200,
+                                      "int", cmd);
+
+  try
+  {
+    cmd.parse(argc, argv);
+  }
+  catch (const TCLAP::ArgException& e)
+  {
+    std::cerr << "error: " << e.error() << " for arg " << e.argId() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Instrumentation of the library would be measured along with the operations
+  Profiler::getDefault().setEnabled(false);
+
+  cv::Size size(1280, 720);
+  double fps = 30;
+  int nb_frames = nb_frames_arg.getValue();
+  int nb_iterations = iterations_arg.getValue();
+  std::string video_path = tmp_arg.getValue() + "/hl_monitoring_bench.avi";
+  generateVideo(video_path, nb_frames, size, fps);
+  std::string chunk_path = tmp_arg.getValue() + "/hl_monitoring_bench." + jpeg_chunk_extension;
+  generateJpegChunk(video_path, chunk_path);
+
+  Field field;
+  std::shared_ptr<const CameraMetaInformation> camera_meta = buildCameraMetaInformation(size);
+
+  Json::Value result;
+  result["schema_version"] = schema_version;
+  result["unit"] = "us";
+  result["config"]["img_width"] = size.width;
+  result["config"]["img_height"] = size.height;
+  result["config"]["nb_frames"] = nb_frames;
+  result["config"]["iterations"] = nb_iterations;
+  result["replay"] = benchReplay(video_path, chunk_path, nb_frames);
+  result["field"] = benchField(field, camera_meta, size, nb_iterations);
+  result["drawers"] = benchDrawers(field, camera_meta, size, nb_iterations);
+
+  std::remove(video_path.c_str());
+  std::remove((video_path + ".keyframes.json").c_str());
+  std::remove(chunk_path.c_str());
+  std::remove(getJpegOffsetsPath(chunk_path).c_str());
+
+  if (output_arg.getValue() != "")
+  {
+    writeJson(result, output_arg.getValue(), true);
+  }
+  else
+  {
+    std::cout << result << std::endl;
+  }
+}
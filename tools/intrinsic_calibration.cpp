@@ -7,6 +7,7 @@
 
 #include <hl_communication/utils.h>
 #include <hl_monitoring/replay_image_provider.h>
+#include <hl_monitoring/undistorter.h>
 
 #include <opencv2/opencv.hpp>
 #include <tclap/CmdLine.h>
@@ -144,25 +145,24 @@ int main(int argc, char** argv)
   std::cout << "Camera Matrix: " << camera_matrix << std::endl;
   std::cout << "Distortion Coeffs: " << distortion_coeffs << std::endl;
 
+  IntrinsicParameters result;
+  cvToIntrinsic(camera_matrix, distortion_coeffs, img_size, &result);
+
   if (show_switch.getValue())
   {
-    cv::Mat optimalMatrix;
-    optimalMatrix = cv::getOptimalNewCameraMatrix(camera_matrix, distortion_coeffs, img_size, 0.0);
-    cv::Mat undistorded;
+    // Undistortion maps are computed once for the whole video
+    Undistorter undistorter;
     image_provider.restartStream();
     while (!image_provider.isStreamFinished())
     {
       cv::Mat img = image_provider.getNextImg();
-      // Undistort
-      cv::undistort(img, undistorded, camera_matrix, distortion_coeffs);  //, optimalMatrix);
+      cv::Mat undistorded = undistorter.undistort(img, result);
       cv::imshow("img", img);
       cv::imshow("undistorded", undistorded);
       cv::waitKey(sleep_time);
     }
   }
 
-  IntrinsicParameters result;
-  cvToIntrinsic(camera_matrix, distortion_coeffs, img_size, &result);
   std::ofstream out(output_arg.getValue());
   if (!out.good())
   {
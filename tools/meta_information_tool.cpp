@@ -1,5 +1,6 @@
 #include <hl_communication/utils.h>
 #include <hl_communication/camera.pb.h>
+#include <hl_monitoring/meta_information_log.h>
 #include <hl_monitoring/replay_image_provider.h>
 
 #include <tclap/CmdLine.h>
@@ -46,7 +47,7 @@ int main(int argc, char** argv)
 
   if (meta_arg.getValue() != "")
   {
-    readFromFile(meta_arg.getValue(), &information);
+    readMetaInformation(meta_arg.getValue(), &information);
   }
   if (pose_arg.getValue() != "")
   {